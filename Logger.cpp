@@ -0,0 +1,189 @@
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+
+namespace {
+    // число записей в буфере одного потока
+    const size_t records_per_thread = 1024;
+
+    // копирует text в буфер записи; не поместившийся текст обрезается по границе символа UTF-8
+    // и помечается "...", перевод строки в конце сохраняется, чтобы не сломать формат журнала
+    uint16_t copy_text(std::string_view text, char* out, size_t capacity) {
+        if (text.size() <= capacity) {
+            // у пустого string_view data() может быть nullptr, а memcpy не принимает его даже с нулевой длиной
+            if (!text.empty()) {
+                std::memcpy(out, text.data(), text.size());
+            }
+            return static_cast<uint16_t>(text.size());
+        }
+        std::string_view marker = text.back() == '\n' ? "...\n" : "...";
+        size_t size = capacity - marker.size();
+        while (size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) {
+            --size;
+        }
+        std::memcpy(out, text.data(), size);
+        std::memcpy(out + size, marker.data(), marker.size());
+        return static_cast<uint16_t>(size + marker.size());
+    }
+}
+
+
+Logger::Logger(const std::string& path_, LogOverflowPolicy overflow_policy_) :
+        file(path_), overflow_policy(overflow_policy_), records(records_per_thread), stopped(false), dropped(0) {
+    push(RecordType::server_start, std::time(nullptr), 0, 0, {});
+    writer = std::thread(&Logger::write_loop, this);
+}
+
+
+Logger::~Logger() {
+    push(RecordType::server_end, std::time(nullptr), 0, 0, {});
+    stopped.store(true);
+    {
+        std::lock_guard<std::mutex> wm(writer_mutex);
+    }
+    writer_cv.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    write_pending();
+    file.close();
+}
+
+
+std::string Logger::getCurrentTimeFormatted(const std::time_t& time) {
+    std::tm tm{};
+    localtime_r(&time, &tm);
+
+    std::ostringstream oss;
+    oss << std::setfill('0')
+        << std::setw(2) << tm.tm_hour << ":"
+        << std::setw(2) << tm.tm_min << ":"
+        << std::setw(2) << tm.tm_sec << ", "
+        << std::setw(2) << tm.tm_mday << "."
+        << std::setw(2) << (tm.tm_mon + 1) << "."
+        << std::setw(2) << (tm.tm_year % 100);
+
+    return oss.str();
+}
+
+
+void Logger::push(RecordType type, std::time_t first_time, std::time_t second_time, size_t value, std::string_view text) {
+    Record record;
+    record.type = type;
+    record.stamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    record.first_time = first_time;
+    record.second_time = second_time;
+    record.value = value;
+    record.text_size = copy_text(text, record.text, sizeof(record.text));
+
+    MT::SpscQueue<Record>& queue = records.local();
+    while (!queue.try_push(std::move(record))) {
+        if (overflow_policy == LogOverflowPolicy::drop) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // будим писателя раньше срока и ждём, пока он освободит место
+        writer_cv.notify_one();
+        std::this_thread::yield();
+    }
+}
+
+
+void Logger::add_record_about_task(const std::time_t& start_time, const std::time_t& end_time, std::string_view task_description) {
+    push(RecordType::task, start_time, end_time, 0, task_description);
+}
+
+
+void Logger::log_start(const std::time_t& time) {
+    push(RecordType::resumed, time, 0, 0, {});
+}
+
+
+void Logger::log_paused(const std::time_t& time) {
+    push(RecordType::paused, time, 0, 0, {});
+}
+
+
+void Logger::log_error(const std::time_t& time, std::string_view error_info) {
+    push(RecordType::error, time, 0, 0, error_info);
+}
+
+
+void Logger::log_deadlock(const std::time_t& time, size_t count_of_threads) {
+    push(RecordType::deadlock, time, 0, count_of_threads, {});
+}
+
+
+size_t Logger::dropped_records() const {
+    return dropped.load();
+}
+
+
+void Logger::render(const Record& record, std::string& out) {
+    std::string_view text(record.text, record.text_size);
+    switch (record.type) {
+        case RecordType::server_start:
+            out += "Server start working; time: " + getCurrentTimeFormatted(record.first_time) + "\n\n";
+            break;
+        case RecordType::server_end:
+            out += "Server end working; time: " + getCurrentTimeFormatted(record.first_time) + "\n\n";
+            break;
+        case RecordType::task:
+            out += "Soleved task with description:\n";
+            out += text;
+            out += "Start working: " + getCurrentTimeFormatted(record.first_time) + '\n';
+            out += "End working: " + getCurrentTimeFormatted(record.second_time) + '\n';
+            out += "Duration: " + std::to_string(record.second_time - record.first_time) + " sec\n\n";
+            break;
+        case RecordType::resumed:
+            out += "The server operation has been resumed: " + getCurrentTimeFormatted(record.first_time) + "\n\n";
+            break;
+        case RecordType::paused:
+            out += "The server has been suspended: " + getCurrentTimeFormatted(record.first_time) + "\n\n";
+            break;
+        case RecordType::error:
+            out += "An error has occurred: ";
+            out += text;
+            out += "\nTime: " + getCurrentTimeFormatted(record.first_time) + "\n\n";
+            break;
+        case RecordType::deadlock:
+            out += "Deadlock has occurred, a new thread has been created\nCurrent number of threads - " +
+                   std::to_string(record.value) + ", new number of threads - " + std::to_string(record.value + 1) + '\n';
+            out += "Time: " + getCurrentTimeFormatted(record.first_time) + "\n\n";
+            break;
+    }
+}
+
+
+size_t Logger::write_pending() {
+    batch.clear();
+    size_t count = records.drain([this](const Record& record) { batch.push_back(record); });
+    // буферы разбираются по очереди, поэтому записи разных потоков перемешиваются по времени;
+    // внутри буфера они уже упорядочены, и устойчивая сортировка этот порядок сохраняет
+    std::stable_sort(batch.begin(), batch.end(), [](const Record& left, const Record& right) {
+        return left.stamp < right.stamp;
+    });
+    std::string out;
+    for (const Record& record : batch) {
+        render(record, out);
+    }
+    if (count != 0) {
+        file.write(out.data(), out.size());
+        file.flush();
+    }
+    return count;
+}
+
+
+void Logger::write_loop() {
+    while (!stopped.load()) {
+        if (write_pending() == 0) {
+            std::unique_lock<std::mutex> lock(writer_mutex);
+            writer_cv.wait_for(lock, std::chrono::milliseconds(20), [this]() -> bool { return stopped.load(); });
+        }
+    }
+}
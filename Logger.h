@@ -2,83 +2,106 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "spsc_queue.h"
+
+
+// Что делать, если буфер записей потока переполнен
+enum class LogOverflowPolicy {
+    // запись отбрасывается (учитывается в dropped_records)
+    drop,
+    // поток ждёт, пока фоновый поток не освободит место
+    block
+};
+
+
+// Асинхронный логгер: потоки кладут записи фиксированного размера в свои SPSC буферы,
+// а единственный фоновый поток держит файл открытым, форматирует записи и пишет их пачками.
+// Внутри пачки записи разных потоков упорядочиваются по времени добавления; запись, добавленная
+// в момент разбора буферов, может попасть в следующую пачку, то есть между потоками порядок
+// соблюдается с точностью до одной пачки (около 20 мс), а внутри одного потока - всегда
+struct Logger {
 
+    enum class RecordType : uint8_t {
+        server_start,
+        server_end,
+        task,
+        resumed,
+        paused,
+        error,
+        deadlock
+    };
 
-struct Logger {
 
-    Logger(std::mutex& logger_mutex) {
-        std::lock_guard<std::mutex> lock(logger_mutex);
-        std::ofstream file("../log_file.txt");
-
-        file << "Server start working; time: ";
-        file << getCurrentTimeFormatted(std::time(nullptr)) << "\n\n";
-        file.close();
-    }
-
-
-    std::string getCurrentTimeFormatted(const std::time_t& time) {
-        std::tm* tm = std::localtime(&time);
-
-        std::ostringstream oss;
-        oss << std::setfill('0') 
-            << std::setw(2) << tm->tm_hour << ":"
-            << std::setw(2) << tm->tm_min << ":"
-            << std::setw(2) << tm->tm_sec << ", "
-            << std::setw(2) << tm->tm_mday << "."
-            << std::setw(2) << (tm->tm_mon + 1) << "."
-            << std::setw(2) << (tm->tm_year % 100);
-
-        return oss.str();
-    }
-
-
-    void add_record_about_task(const std::time_t& start_time, const std::time_t& end_time, const std::string& task_description) {
-        std::ofstream file("../log_file.txt", std::ios::app);
-        file << "Soleved task with description:\n" << task_description;
-        file << "Start working: " << getCurrentTimeFormatted(start_time) << '\n';
-        file << "End working: " << getCurrentTimeFormatted(end_time) << '\n';
-        file << "Duration: " << (end_time - start_time) << " sec\n\n";
-        file.close();
-    }
-
-
-    void log_start(const std::time_t& time) {
-        std::ofstream file("../log_file.txt", std::ios::app);
-        file << "The server operation has been resumed: " << getCurrentTimeFormatted(time) << "\n\n";
-        file.close();
-    }
-
-
-    void log_paused(const std::time_t& time) {
-        std::ofstream file("../log_file.txt", std::ios::app);
-        file << "The server has been suspended: " << getCurrentTimeFormatted(time) << "\n\n";
-        file.close();
-    }
-
-
-    void log_error(const std::time_t& time, const std::string& error_info) {
-        std::ofstream file("../log_file.txt", std::ios::app);
-        file << "An error has occurred: " << error_info << '\n';
-        file << "Time: " << getCurrentTimeFormatted(time) << "\n\n";
-        file.close();
-    }
-
-
-    void log_deadlock(const std::time_t& time, size_t count_of_threads) {
-        std::ofstream file("../log_file.txt", std::ios::app);
-        file << "Deadlock has occurred, a new thread has been created\n" 
-             << "Current number of threads - " 
-             << count_of_threads << ", new number of threads - " 
-             << count_of_threads + 1 << '\n';
-        file << "Time: " << getCurrentTimeFormatted(time) << "\n\n";
-        file.close();
-    }
-
-
-    ~Logger() {
-        std::ofstream file("../log_file.txt", std::ios::app);
-        file << "Server end working; time: ";
-        file << getCurrentTimeFormatted(std::time(nullptr)) << "\n\n";
-        file.close();
-    }
-};
\ No newline at end of file
+    // Запись фиксированного размера (256 байт), текст длиннее text обрезается и помечается "..."
+    struct Record {
+        RecordType type;
+        uint16_t text_size;
+        // steady_clock в наносекундах, для упорядочивания записей разных потоков
+        uint64_t stamp;
+        std::time_t first_time;
+        // время окончания задачи для RecordType::task
+        std::time_t second_time;
+        // число потоков для RecordType::deadlock
+        size_t value;
+        char text[216];
+    };
+
+
+    Logger(const std::string& path_ = "../log_file.txt", LogOverflowPolicy overflow_policy_ = LogOverflowPolicy::drop);
+
+    Logger(const Logger& other) = delete;
+    Logger& operator=(const Logger& other) = delete;
+
+
+    // потокобезопасное форматирование времени
+    static std::string getCurrentTimeFormatted(const std::time_t& time);
+
+
+    void add_record_about_task(const std::time_t& start_time, const std::time_t& end_time, std::string_view task_description);
+
+    void log_start(const std::time_t& time);
+
+    void log_paused(const std::time_t& time);
+
+    void log_error(const std::time_t& time, std::string_view error_info);
+
+    void log_deadlock(const std::time_t& time, size_t count_of_threads);
+
+    size_t dropped_records() const;
+
+    ~Logger();
+
+ private:
+    std::ofstream file;
+    const LogOverflowPolicy overflow_policy;
+
+    MT::PerThreadQueues<Record> records;
+
+    std::mutex writer_mutex;
+    std::condition_variable writer_cv;
+    std::thread writer;
+    std::atomic<bool> stopped;
+    std::atomic<size_t> dropped;
+
+    // записи очередной пачки, используется только пишущим потоком
+    std::vector<Record> batch;
+
+    void push(RecordType type, std::time_t first_time, std::time_t second_time, size_t value, std::string_view text);
+
+    // переводит запись в текст прежнего формата
+    static void render(const Record& record, std::string& out);
+
+    // разбирает буферы и пишет всё в файл одной операцией, возвращает число записей
+    size_t write_pending();
+
+    void write_loop();
+};
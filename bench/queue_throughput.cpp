@@ -0,0 +1,111 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../thread_pool.h"
+
+
+// Сравнение пропускной способности вариантов очереди задач (MT::QueueType)
+// на задачах с пустым телом
+
+namespace {
+
+    struct EmptyTask : public MT::Task {
+        EmptyTask() : MT::Task("") {}
+
+        void one_thread_method() override {}
+        void show_result() override {}
+    };
+
+
+    // Задача, порождающая children пустых подзадач прямо из пула
+    struct SpawningTask : public MT::Task {
+        size_t children;
+
+        SpawningTask(size_t children_) : MT::Task(""), children(children_) {}
+
+        void one_thread_method() override {
+            for (size_t i = 0; i < children; ++i) {
+                thread_pool->add_task(std::make_shared<EmptyTask>());
+            }
+        }
+        void show_result() override {}
+    };
+
+
+    // producers внешних потоков одновременно добавляют задачи
+    double run_external(MT::QueueType queue_type, size_t threads, size_t producers, size_t tasks) {
+        MT::PoolOptions options;
+        options.queue_type = queue_type;
+        MT::ThreadPool pool(threads, options);
+        pool.set_logger_flag(false);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.start();
+        std::vector<std::thread> producer_threads;
+        for (size_t p = 0; p < producers; ++p) {
+            producer_threads.emplace_back([&pool, tasks, producers]() {
+                for (size_t i = 0; i < tasks / producers; ++i) {
+                    pool.add_task(std::make_shared<EmptyTask>());
+                }
+            });
+        }
+        for (std::thread& producer : producer_threads) {
+            producer.join();
+        }
+        pool.wait();
+        auto end = std::chrono::steady_clock::now();
+        return tasks / producers * producers / std::chrono::duration<double>(end - start).count();
+    }
+
+
+    double run_nested(MT::QueueType queue_type, size_t threads, size_t parents, size_t children) {
+        MT::PoolOptions options;
+        options.queue_type = queue_type;
+        MT::ThreadPool pool(threads, options);
+        pool.set_logger_flag(false);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.start();
+        for (size_t i = 0; i < parents; ++i) {
+            pool.add_task(std::make_shared<SpawningTask>(children));
+        }
+        pool.wait();
+        auto end = std::chrono::steady_clock::now();
+        return parents * (children + 1) / std::chrono::duration<double>(end - start).count();
+    }
+
+
+    const char* name(MT::QueueType queue_type) {
+        switch (queue_type) {
+            case MT::QueueType::global_queue: return "global_queue";
+            case MT::QueueType::work_stealing: return "work_stealing";
+            case MT::QueueType::bounded_ring: return "bounded_ring";
+        }
+        return "";
+    }
+}
+
+
+int main(int argc, char** argv) {
+    size_t threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    size_t tasks = argc > 2 ? std::stoul(argv[2]) : 200'000;
+    size_t producers = argc > 3 ? std::stoul(argv[3]) : 4;
+
+    std::vector<std::string> lines;
+    for (MT::QueueType queue_type : {MT::QueueType::global_queue, MT::QueueType::work_stealing, MT::QueueType::bounded_ring}) {
+        double external = run_external(queue_type, threads, 1, tasks);
+        double contended = run_external(queue_type, threads, producers, tasks);
+        double nested = run_nested(queue_type, threads, tasks / 1000, 1000);
+        lines.push_back(std::string(name(queue_type)) + ": external " + std::to_string(static_cast<size_t>(external)) +
+                        " tasks/s, " + std::to_string(producers) + " producers " + std::to_string(static_cast<size_t>(contended)) +
+                        " tasks/s, nested " + std::to_string(static_cast<size_t>(nested)) + " tasks/s");
+    }
+
+    std::cout << "threads: " << threads << ", tasks: " << tasks << ", producers: " << producers << '\n';
+    for (const std::string& line : lines) {
+        std::cout << line << '\n';
+    }
+    return 0;
+}
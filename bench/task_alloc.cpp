@@ -0,0 +1,196 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include "../thread_pool.h"
+
+
+// Число выделений памяти на одну задачу для разных способов её добавления в пул.
+// Глобальные operator new/delete подменены всем семейством (массивы, nothrow, выровненные):
+// сами Job выделяются обычным operator new, но деки, кольцо и счётчики потоков объявлены
+// с alignas(64) и выделяются через std::align_val_t. Пул прогревается перед замером
+
+namespace {
+    std::atomic<size_t> allocations{0};
+
+    // выделение и освобождение вынесены из операторов: иначе компилятор, видя malloc в встроенном
+    // operator new и free в operator delete, предупреждает о несогласованной паре (-Wmismatched-new-delete)
+    [[gnu::noinline]] void* allocate(size_t size, size_t alignment) noexcept {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        size = size == 0 ? 1 : size;
+        if (alignment <= alignof(std::max_align_t)) {
+            return std::malloc(size);
+        }
+        // aligned_alloc требует размер, кратный выравниванию
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+
+    [[gnu::noinline]] void release(void* ptr) noexcept {
+        std::free(ptr);
+    }
+
+    void* allocate_or_throw(size_t size, size_t alignment) {
+        if (void* ptr = allocate(size, alignment)) {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+
+void* operator new(size_t size) {
+    return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size) {
+    return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+
+void operator delete(void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(ptr);
+}
+
+
+namespace {
+
+    struct EmptyTask : public MT::Task {
+        EmptyTask() : MT::Task("Empty task\n") {}
+
+        void one_thread_method() override {}
+        void show_result() override {}
+    };
+
+
+    // прогоняет add(pool, tasks) дважды и возвращает число выделений на задачу во втором прогоне
+    template <typename Add>
+    double allocations_per_task(MT::ThreadPool& pool, size_t tasks, Add add) {
+        add(pool, tasks);
+        pool.wait();
+
+        size_t before = allocations.load();
+        add(pool, tasks);
+        pool.wait();
+        return static_cast<double>(allocations.load() - before) / tasks;
+    }
+}
+
+
+int main(int argc, char** argv) {
+    size_t threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    size_t tasks = argc > 2 ? std::stoul(argv[2]) : 100'000;
+
+    MT::ThreadPool pool(threads);
+    pool.set_logger_flag(false);
+
+    std::atomic<size_t> counter{0};
+
+    double post = allocations_per_task(pool, tasks, [&counter](MT::ThreadPool& pool, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            pool.post([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+        }
+    });
+
+    // задачи порождают подзадачи из потоков пула
+    double nested_post = allocations_per_task(pool, tasks, [&counter](MT::ThreadPool& pool, size_t count) {
+        const size_t children = 1000;
+        for (size_t i = 0; i < count / children; ++i) {
+            pool.post([&pool, &counter, children]() {
+                for (size_t j = 1; j < children; ++j) {
+                    pool.post([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+    });
+
+    double submit = allocations_per_task(pool, tasks, [](MT::ThreadPool& pool, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            pool.submit([i]() { return i; });
+        }
+    });
+
+    double add_task = allocations_per_task(pool, tasks, [](MT::ThreadPool& pool, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            pool.add_task(std::make_shared<EmptyTask>());
+        }
+        pool.clear_completed();
+    });
+
+    std::cout << "threads: " << threads << ", tasks: " << tasks << '\n';
+    std::cout << "post(lambda): " << post << " allocations/task\n";
+    std::cout << "nested post(lambda): " << nested_post << " allocations/task\n";
+    std::cout << "submit(lambda): " << submit << " allocations/task\n";
+    std::cout << "add_task(make_shared): " << add_task << " allocations/task\n";
+    return 0;
+}
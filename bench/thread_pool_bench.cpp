@@ -0,0 +1,549 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../thread_pool.h"
+#include "../task_group.h"
+#include "../parallel_sort.h"
+#include "../sort_kernels.h"
+#include "../test/test_tasks.h"
+
+
+// Набор замеров пула для отслеживания регрессий между версиями:
+// пропускная способность на пустых задачах, задержка от добавления до начала выполнения,
+// разветвление и сведение (как SortBigVec), вложенное порождение задач и поиск по файлу
+// (SearchInALargeFile), MT::parallel_sort и поразрядная MT::parallel_radix_sort против std::sort
+// и std::sort(std::execution::par).
+// Каждый замер повторяется для всех вариантов очереди (MT::QueueType),
+// результат печатается одним JSON объектом в stdout, ход замеров - в stderr.
+//
+// thread_pool_bench [--threads N] [--producers N] [--tasks N] [--repeat N] [--corpus-mb N]
+//                   [--sort-elements N] [--only throughput,latency,fan_out,nested,search,sort] [--label TEXT]
+
+namespace {
+
+    const char* usage =
+        "usage: thread_pool_bench [--threads N] [--producers N] [--tasks N] [--repeat N] [--corpus-mb N]\n"
+        "                         [--sort-elements N] [--only throughput,latency,fan_out,nested,search,sort] [--label TEXT]\n";
+
+
+    struct BenchOptions {
+        size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t producers = std::max(1u, std::thread::hardware_concurrency());
+        size_t tasks = 200'000;
+        size_t repeat = 3;
+        size_t corpus_mb = 32;
+        size_t sort_elements = 1 << 24;
+        // произвольная метка прогона (например, версия или аллокатор), попадает в JSON
+        std::string label;
+        std::vector<std::string> only;
+
+        bool enabled(const std::string& benchmark) const {
+            return only.empty() || std::ranges::find(only, benchmark) != only.end();
+        }
+    };
+
+
+    // Поля одного результата в порядке добавления
+    class JsonRecord {
+        std::vector<std::pair<std::string, std::string>> fields;
+
+        static std::string quote(const std::string& text) {
+            std::string result = "\"";
+            for (char c : text) {
+                switch (c) {
+                    case '"': result += "\\\""; break;
+                    case '\\': result += "\\\\"; break;
+                    case '\n': result += "\\n"; break;
+                    case '\t': result += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char escaped[8];
+                            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                            result += escaped;
+                        } else {
+                            result += c;
+                        }
+                }
+            }
+            return result + "\"";
+        }
+
+     public:
+        JsonRecord& text(const std::string& key, const std::string& value) {
+            fields.emplace_back(key, quote(value));
+            return *this;
+        }
+
+        JsonRecord& number(const std::string& key, double value) {
+            std::ostringstream out;
+            out.precision(9);
+            out << value;
+            fields.emplace_back(key, out.str());
+            return *this;
+        }
+
+        JsonRecord& flag(const std::string& key, bool value) {
+            fields.emplace_back(key, value ? "true" : "false");
+            return *this;
+        }
+
+        // вложенный объект или массив, уже записанный в JSON
+        JsonRecord& raw(const std::string& key, const std::string& json) {
+            fields.emplace_back(key, json);
+            return *this;
+        }
+
+        std::string str() const {
+            std::string result = "{";
+            for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), fields.size())) {
+                result += (i == 0 ? "" : ", ") + quote(fields[i].first) + ": " + fields[i].second;
+            }
+            return result + "}";
+        }
+    };
+
+
+    // медиана и минимум времени нескольких прогонов
+    struct Timing {
+        double median = 0;
+        double best = 0;
+    };
+
+
+    Timing measure(size_t repeat, const std::function<double()>& run) {
+        std::vector<double> seconds;
+        for ([[maybe_unused]] size_t i : std::ranges::iota_view(static_cast<size_t>(0), std::max<size_t>(1, repeat))) {
+            seconds.push_back(run());
+        }
+        std::ranges::sort(seconds);
+        return Timing{seconds[seconds.size() / 2], seconds.front()};
+    }
+
+
+    double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+
+    // 1, 2, 4, ... и само limit
+    std::vector<size_t> powers_of_two(size_t limit) {
+        std::vector<size_t> values;
+        for (size_t value = 1; value < limit; value *= 2) {
+            values.push_back(value);
+        }
+        values.push_back(limit);
+        return values;
+    }
+
+
+    const char* name(MT::QueueType queue_type) {
+        switch (queue_type) {
+            case MT::QueueType::global_queue: return "global_queue";
+            case MT::QueueType::work_stealing: return "work_stealing";
+            case MT::QueueType::bounded_ring: return "bounded_ring";
+        }
+        return "";
+    }
+
+
+    MT::PoolOptions pool_options(MT::QueueType queue_type, bool latency_metrics) {
+        MT::PoolOptions options;
+        options.queue_type = queue_type;
+        options.latency_metrics = latency_metrics;
+        return options;
+    }
+
+
+    std::string percentiles_json(const MT::LatencyPercentiles& latency) {
+        auto us = [](std::chrono::nanoseconds ns) { return ns.count() / 1000.0; };
+        return JsonRecord().number("count", latency.count).number("mean_us", us(latency.mean))
+                           .number("p50_us", us(latency.p50)).number("p90_us", us(latency.p90))
+                           .number("p99_us", us(latency.p99)).number("p999_us", us(latency.p999))
+                           .number("max_us", us(latency.max)).str();
+    }
+
+
+    // пустые задачи от producers внешних потоков
+    double run_throughput(MT::QueueType queue_type, size_t threads, size_t producers, size_t tasks) {
+        MT::ThreadPool pool(threads, pool_options(queue_type, false));
+        pool.set_logger_flag(false);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.start();
+        std::vector<std::thread> producer_threads;
+        for (size_t p : std::ranges::iota_view(static_cast<size_t>(0), producers)) {
+            producer_threads.emplace_back([&pool, tasks, producers, p]() {
+                size_t count = tasks / producers + (p < tasks % producers ? 1 : 0);
+                for ([[maybe_unused]] size_t i : std::ranges::iota_view(static_cast<size_t>(0), count)) {
+                    pool.post([]() {});
+                }
+            });
+        }
+        for (std::thread& producer : producer_threads) {
+            producer.join();
+        }
+        pool.wait();
+        return seconds_since(start);
+    }
+
+
+    // idle - задачи добавляются по одной и каждая дожидается (поток пула успевает уснуть),
+    // burst - все задачи добавляются разом
+    MT::LatencyPercentiles run_latency(MT::QueueType queue_type, size_t threads, size_t tasks, bool burst) {
+        MT::ThreadPool pool(threads, pool_options(queue_type, true));
+        pool.set_logger_flag(false);
+        pool.start();
+        if (burst) {
+            for ([[maybe_unused]] size_t i : std::ranges::iota_view(static_cast<size_t>(0), tasks)) {
+                pool.post([]() {});
+            }
+        } else {
+            for ([[maybe_unused]] size_t i : std::ranges::iota_view(static_cast<size_t>(0), tasks)) {
+                pool.submit([]() {}).get();
+            }
+        }
+        pool.wait();
+        return pool.latency_snapshot().overall.queue_wait;
+    }
+
+
+    struct FanOutResult {
+        double sort_seconds = 0;
+        double merge_seconds = 0;
+        bool sorted = false;
+    };
+
+
+    // как SortBigVec, но в памяти: чанки сортируются задачами группы, затем сливаются кучей
+    FanOutResult run_fan_out(MT::QueueType queue_type, size_t threads, size_t elements, size_t chunk_size) {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> dist(std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max());
+        std::vector<int16_t> data(elements);
+        for (int16_t& value : data) {
+            value = static_cast<int16_t>(dist(rng));
+        }
+
+        MT::ThreadPool pool(threads, pool_options(queue_type, false));
+        pool.set_logger_flag(false);
+        pool.start();
+
+        FanOutResult result;
+        auto start = std::chrono::steady_clock::now();
+        {
+            MT::TaskGroup chunks(pool);
+            for (size_t first = 0; first < elements; first += chunk_size) {
+                auto begin = data.begin() + first;
+                auto end = data.begin() + std::min(elements, first + chunk_size);
+                chunks.run([begin, end]() { std::sort(begin, end); });
+            }
+            chunks.wait();
+        }
+        result.sort_seconds = seconds_since(start);
+
+        start = std::chrono::steady_clock::now();
+        using Head = std::pair<int16_t, size_t>;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        std::vector<size_t> positions;
+        for (size_t first = 0; first < elements; first += chunk_size) {
+            heads.emplace(data[first], positions.size());
+            positions.push_back(first);
+        }
+        std::vector<int16_t> merged;
+        merged.reserve(elements);
+        while (!heads.empty()) {
+            auto [value, chunk] = heads.top();
+            heads.pop();
+            merged.push_back(value);
+            size_t next = ++positions[chunk];
+            if (next < std::min(elements, (chunk + 1) * chunk_size)) {
+                heads.emplace(data[next], chunk);
+            }
+        }
+        result.merge_seconds = seconds_since(start);
+        result.sorted = merged.size() == elements && std::ranges::is_sorted(merged);
+        pool.wait();
+        return result;
+    }
+
+
+    // двоичное дерево задач глубины depth: каждая задача добавляет в пул две дочерние из потока пула.
+    // Задачи не ждут детей - с QueueType::global_queue помощь в TaskGroup::wait брала бы задачи
+    // в порядке FIFO, и глубина вложенных ожиданий не была бы ограничена
+    void spawn_tree(MT::ThreadPool& pool, size_t depth) {
+        if (depth == 0) {
+            return;
+        }
+        pool.post([&pool, depth]() { spawn_tree(pool, depth - 1); });
+        pool.post([&pool, depth]() { spawn_tree(pool, depth - 1); });
+    }
+
+
+    double run_nested(MT::QueueType queue_type, size_t threads, size_t depth) {
+        MT::ThreadPool pool(threads, pool_options(queue_type, false));
+        pool.set_logger_flag(false);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.start();
+        pool.post([&pool, depth]() { spawn_tree(pool, depth); });
+        pool.wait();
+        return seconds_since(start);
+    }
+
+
+    // текст из случайных слов; needle встречается примерно в каждой сотой строке
+    std::filesystem::path generate_corpus(size_t megabytes, const std::string& needle) {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "thread_pool_bench_corpus.txt";
+        std::ofstream file(path);
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> letter('a', 'z');
+        std::uniform_int_distribution<int> length(2, 10);
+        std::uniform_int_distribution<int> words_per_line(5, 15);
+        std::uniform_int_distribution<int> percent(0, 99);
+
+        size_t written = 0;
+        std::string line;
+        while (written < megabytes * 1024 * 1024) {
+            line.clear();
+            for (int word : std::ranges::iota_view(0, words_per_line(rng))) {
+                if (word != 0) {
+                    line += ' ';
+                }
+                for ([[maybe_unused]] int c : std::ranges::iota_view(0, length(rng))) {
+                    line += static_cast<char>(letter(rng));
+                }
+            }
+            if (percent(rng) == 0) {
+                line += ' ' + needle;
+            }
+            file << line << '\n';
+            written += line.size() + 1;
+        }
+        return path;
+    }
+
+
+    double run_search(MT::QueueType queue_type, size_t threads, const std::filesystem::path& corpus, const std::string& needle) {
+        MT::ThreadPool pool(threads, pool_options(queue_type, false));
+        pool.set_logger_flag(false);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.add_task(std::make_shared<SearchInALargeFile>(corpus.string(), needle));
+        pool.wait();
+        return seconds_since(start);
+    }
+
+
+    std::vector<uint32_t> random_keys(size_t count) {
+        std::mt19937 rng(11);
+        std::vector<uint32_t> keys(count);
+        for (uint32_t& key : keys) {
+            key = static_cast<uint32_t>(rng());
+        }
+        return keys;
+    }
+
+
+    // время сортировки копии keys функцией sort; результат проверяется
+    template <typename Sort>
+    double run_sort(const std::vector<uint32_t>& keys, Sort sort) {
+        std::vector<uint32_t> data = keys;
+        auto start = std::chrono::steady_clock::now();
+        sort(data);
+        double seconds = seconds_since(start);
+        if (!std::ranges::is_sorted(data)) {
+            throw std::logic_error("sort produced unsorted output");
+        }
+        return seconds;
+    }
+
+
+    BenchOptions parse_options(int argc, char** argv) {
+        BenchOptions options;
+        for (int i = 1; i < argc; i += 2) {
+            std::string key = argv[i];
+            if (i + 1 == argc) {
+                throw std::invalid_argument("Missing value for option " + key);
+            }
+            std::string value = argv[i + 1];
+            if (key == "--threads") {
+                options.threads = std::stoul(value);
+            } else if (key == "--producers") {
+                options.producers = std::stoul(value);
+            } else if (key == "--tasks") {
+                options.tasks = std::stoul(value);
+            } else if (key == "--repeat") {
+                options.repeat = std::stoul(value);
+            } else if (key == "--corpus-mb") {
+                options.corpus_mb = std::stoul(value);
+            } else if (key == "--sort-elements") {
+                options.sort_elements = std::stoul(value);
+            } else if (key == "--label") {
+                options.label = value;
+            } else if (key == "--only") {
+                std::stringstream list(value);
+                std::string benchmark;
+                while (std::getline(list, benchmark, ',')) {
+                    options.only.push_back(benchmark);
+                }
+            } else {
+                throw std::invalid_argument("Unknown option " + key);
+            }
+        }
+        return options;
+    }
+}
+
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        // нечисловое значение std::stoul тоже сообщает исключением
+        std::cerr << e.what() << '\n' << usage;
+        return 1;
+    }
+
+    std::vector<std::string> results;
+    const MT::QueueType queue_types[] = {MT::QueueType::global_queue, MT::QueueType::work_stealing, MT::QueueType::bounded_ring};
+
+    if (options.enabled("throughput")) {
+        for (MT::QueueType queue_type : queue_types) {
+            for (size_t threads : powers_of_two(options.threads)) {
+                for (size_t producers : powers_of_two(options.producers)) {
+                    std::cerr << "throughput " << name(queue_type) << ' ' << threads << " threads " << producers << " producers\n";
+                    Timing timing = measure(options.repeat, [&]() {
+                        return run_throughput(queue_type, threads, producers, options.tasks);
+                    });
+                    results.push_back(JsonRecord().text("benchmark", "throughput").text("queue", name(queue_type))
+                        .number("threads", threads).number("producers", producers).number("tasks", options.tasks)
+                        .number("seconds", timing.median).number("best_seconds", timing.best)
+                        .number("tasks_per_second", options.tasks / timing.median).str());
+                }
+            }
+        }
+    }
+
+    if (options.enabled("latency")) {
+        size_t idle_tasks = std::min<size_t>(options.tasks, 20'000);
+        for (MT::QueueType queue_type : queue_types) {
+            std::cerr << "latency " << name(queue_type) << '\n';
+            MT::LatencyPercentiles idle = run_latency(queue_type, options.threads, idle_tasks, false);
+            MT::LatencyPercentiles burst = run_latency(queue_type, options.threads, options.tasks, true);
+            results.push_back(JsonRecord().text("benchmark", "submit_to_start_latency").text("queue", name(queue_type))
+                .number("threads", options.threads).raw("idle", percentiles_json(idle))
+                .raw("burst", percentiles_json(burst)).str());
+        }
+    }
+
+    if (options.enabled("fan_out")) {
+        const size_t elements = 1 << 23;
+        const size_t chunk_size = 1 << 16;
+        for (MT::QueueType queue_type : queue_types) {
+            std::cerr << "fan_out " << name(queue_type) << '\n';
+            bool sorted = true;
+            double merge_seconds = 0;
+            Timing timing = measure(options.repeat, [&]() {
+                FanOutResult result = run_fan_out(queue_type, options.threads, elements, chunk_size);
+                sorted &= result.sorted;
+                merge_seconds = result.merge_seconds;
+                return result.sort_seconds;
+            });
+            results.push_back(JsonRecord().text("benchmark", "fan_out_fan_in").text("queue", name(queue_type))
+                .number("threads", options.threads).number("elements", elements).number("chunks", elements / chunk_size)
+                .number("sort_seconds", timing.median).number("best_sort_seconds", timing.best)
+                .number("merge_seconds", merge_seconds).flag("sorted", sorted).str());
+        }
+    }
+
+    if (options.enabled("nested")) {
+        const size_t depth = 16;
+        const size_t tasks = (size_t(1) << (depth + 1)) - 1;
+        for (MT::QueueType queue_type : queue_types) {
+            std::cerr << "nested " << name(queue_type) << '\n';
+            Timing timing = measure(options.repeat, [&]() { return run_nested(queue_type, options.threads, depth); });
+            results.push_back(JsonRecord().text("benchmark", "nested_spawn").text("queue", name(queue_type))
+                .number("threads", options.threads).number("depth", depth).number("tasks", tasks)
+                .number("seconds", timing.median).number("best_seconds", timing.best)
+                .number("tasks_per_second", tasks / timing.median).str());
+        }
+    }
+
+    if (options.enabled("search")) {
+        const std::string needle = "threadpool";
+        std::cerr << "generating " << options.corpus_mb << " MB corpus\n";
+        std::filesystem::path corpus = generate_corpus(options.corpus_mb, needle);
+        for (MT::QueueType queue_type : queue_types) {
+            std::cerr << "search " << name(queue_type) << '\n';
+            Timing timing = measure(options.repeat, [&]() { return run_search(queue_type, options.threads, corpus, needle); });
+            results.push_back(JsonRecord().text("benchmark", "search_in_file").text("queue", name(queue_type))
+                .number("threads", options.threads).number("corpus_mb", options.corpus_mb)
+                .number("seconds", timing.median).number("best_seconds", timing.best)
+                .number("mb_per_second", options.corpus_mb / timing.median).str());
+        }
+        std::filesystem::remove(corpus);
+    }
+
+    if (options.enabled("sort")) {
+        std::vector<uint32_t> keys = random_keys(options.sort_elements);
+        std::cerr << "sort std::sort\n";
+        Timing sequential = measure(options.repeat, [&]() {
+            return run_sort(keys, [](std::vector<uint32_t>& data) { std::sort(data.begin(), data.end()); });
+        });
+        std::cerr << "sort std::execution::par\n";
+        Timing standard_parallel = measure(options.repeat, [&]() {
+            return run_sort(keys, [](std::vector<uint32_t>& data) { std::sort(std::execution::par, data.begin(), data.end()); });
+        });
+        std::cerr << "sort MT::radix_sort\n";
+        Timing sequential_radix = measure(options.repeat, [&]() {
+            return run_sort(keys, [](std::vector<uint32_t>& data) { MT::radix_sort(std::span<uint32_t>(data)); });
+        });
+        for (MT::QueueType queue_type : queue_types) {
+            std::cerr << "sort " << name(queue_type) << '\n';
+            MT::ThreadPool pool(options.threads, pool_options(queue_type, false));
+            pool.set_logger_flag(false);
+            pool.start();
+            Timing timing = measure(options.repeat, [&]() {
+                return run_sort(keys, [&pool](std::vector<uint32_t>& data) { MT::parallel_sort(pool, data); });
+            });
+            Timing radix = measure(options.repeat, [&]() {
+                return run_sort(keys, [&pool](std::vector<uint32_t>& data) { MT::parallel_radix_sort(pool, std::span<uint32_t>(data)); });
+            });
+            pool.wait();
+            results.push_back(JsonRecord().text("benchmark", "parallel_radix_sort").text("queue", name(queue_type))
+                .number("threads", options.threads).number("elements", options.sort_elements)
+                .number("seconds", radix.median).number("best_seconds", radix.best)
+                .number("radix_sort_seconds", sequential_radix.median)
+                .number("speedup_vs_std_sort", sequential.median / radix.median).str());
+            results.push_back(JsonRecord().text("benchmark", "parallel_sort").text("queue", name(queue_type))
+                .number("threads", options.threads).number("elements", options.sort_elements)
+                .number("seconds", timing.median).number("best_seconds", timing.best)
+                .number("std_sort_seconds", sequential.median).number("std_par_sort_seconds", standard_parallel.median)
+                .number("speedup_vs_std_sort", sequential.median / timing.median)
+                .number("speedup_vs_std_par_sort", standard_parallel.median / timing.median).str());
+        }
+    }
+
+    std::string results_json = "[";
+    for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), results.size())) {
+        results_json += (i == 0 ? "\n    " : ",\n    ") + results[i];
+    }
+    results_json += "\n  ]";
+
+    std::cout << JsonRecord().text("suite", "thread_pool_bench").text("label", options.label)
+        .number("hardware_concurrency", std::thread::hardware_concurrency()).number("repeat", options.repeat)
+        .raw("results", results_json).str() << '\n';
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "event_sink.h"
+#include <iostream>
+
+
+std::mutex& MT::console_mutex() {
+	static std::mutex mutex;
+	return mutex;
+}
+
+
+void MT::ConsoleEventSink::on_event(const MT::TaskEvent& event) {
+	std::lock_guard<std::mutex> cm(MT::console_mutex());
+	switch (event.type) {
+		case MT::TaskEventType::submitted:
+			std::cout << "Task submitted with ID: " << event.task_id << '\n';
+			break;
+		case MT::TaskEventType::failed:
+		case MT::TaskEventType::pool_error:
+			std::cerr << event.message << '\n';
+			break;
+		default:
+			break;
+	}
+}
+
+
+MT::EventDispatcher::EventDispatcher(size_t buffer_capacity_) :
+		buffers(buffer_capacity_), enabled(false), stopped(false), dropped(0) {}
+
+
+MT::EventDispatcher::~EventDispatcher() {
+	stopped.store(true);
+	{
+		std::lock_guard<std::mutex> cm(consumer_mutex);
+	}
+	consumer_cv.notify_all();
+	if (consumer.joinable()) {
+		consumer.join();
+	}
+	drain();
+}
+
+
+void MT::EventDispatcher::set_sink(std::shared_ptr<MT::EventSink> sink_) {
+	{
+		std::lock_guard<std::mutex> sm(sink_mutex);
+		sink = std::move(sink_);
+		enabled.store(sink != nullptr);
+	}
+	// фоновый поток создаётся только при появлении первого получателя
+	std::lock_guard<std::mutex> cm(consumer_mutex);
+	if (enabled.load() && !consumer.joinable()) {
+		consumer = std::thread(&EventDispatcher::consume, this);
+	}
+}
+
+
+void MT::EventDispatcher::publish(MT::TaskEventType type, size_t task_id, std::string message) {
+	if (!is_enabled()) {
+		return;
+	}
+	MT::TaskEvent event{type, task_id, std::chrono::system_clock::now(), std::move(message)};
+	if (!buffers.local().try_push(std::move(event))) {
+		dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+size_t MT::EventDispatcher::drain() {
+	std::lock_guard<std::mutex> dm(drain_mutex);
+
+	std::shared_ptr<MT::EventSink> current_sink;
+	{
+		std::lock_guard<std::mutex> sm(sink_mutex);
+		current_sink = sink;
+	}
+
+	return buffers.drain([&current_sink](const MT::TaskEvent& event) {
+		if (current_sink) {
+			current_sink->on_event(event);
+		}
+	});
+}
+
+
+void MT::EventDispatcher::consume() {
+	while (!stopped.load()) {
+		if (drain() == 0) {
+			std::unique_lock<std::mutex> lock(consumer_mutex);
+			consumer_cv.wait_for(lock, std::chrono::milliseconds(5), [this]() -> bool { return stopped.load(); });
+		}
+	}
+}
+
+
+void MT::EventDispatcher::flush() {
+	drain();
+}
+
+
+size_t MT::EventDispatcher::dropped_events() const {
+	return dropped.load();
+}
+
+
+size_t MT::EventDispatcher::buffer_count() {
+	return buffers.queue_count();
+}
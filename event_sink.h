@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.h"
+
+
+namespace MT {
+
+    // Этапы жизни задачи в пуле
+    enum class TaskEventType {
+        submitted,
+        started,
+        finished,
+        failed,
+        // ошибка самого пула, не связанная с задачей (task_id == 0): не удалось создать или дождаться поток
+        pool_error
+    };
+
+
+    struct TaskEvent {
+        MT::TaskEventType type = MT::TaskEventType::submitted;
+        size_t task_id = 0;
+        std::chrono::system_clock::time_point time;
+        // текст ошибки, заполняется только для TaskEventType::failed и TaskEventType::pool_error
+        std::string message;
+    };
+
+
+    // Получатель событий пула. Вызывается только из фонового потока EventDispatcher,
+    // поэтому может спокойно писать в консоль или файл
+    class EventSink {
+     public:
+        virtual void on_event(const MT::TaskEvent& event) = 0;
+
+        virtual ~EventSink() = default;
+    };
+
+
+    // мьютекс вывода в консоль: под ним печатают ConsoleEventSink и ThreadPool::get_result,
+    // чтобы их строки не перемешивались
+    std::mutex& console_mutex();
+
+
+    // Пишет в консоль то, что раньше печатал сам пул: добавление задач и ошибки
+    class ConsoleEventSink : public EventSink {
+     public:
+        void on_event(const MT::TaskEvent& event) override;
+    };
+
+
+    // Доставка событий от потоков пула к EventSink.
+    // Каждый публикующий поток пишет в свой SPSC буфер без блокировок,
+    // фоновый поток разбирает буферы и передаёт события получателю.
+    // Буфер завершившегося потока освобождается, как только из него доставлены все события.
+    // Без получателя (по умолчанию) события не создаются вовсе.
+    class EventDispatcher {
+        MT::PerThreadQueues<MT::TaskEvent> buffers;
+
+        // только один поток может разбирать буферы одновременно
+        std::mutex drain_mutex;
+
+        std::mutex sink_mutex;
+        std::shared_ptr<MT::EventSink> sink;
+        std::atomic<bool> enabled;
+
+        std::mutex consumer_mutex;
+        std::condition_variable consumer_cv;
+        std::thread consumer;
+        std::atomic<bool> stopped;
+
+        // события, не поместившиеся в переполненный буфер
+        std::atomic<size_t> dropped;
+
+        // разбирает все буферы, возвращает число доставленных событий
+        size_t drain();
+
+        void consume();
+
+     public:
+        explicit EventDispatcher(size_t buffer_capacity_ = 4096);
+
+        EventDispatcher(const EventDispatcher& other) = delete;
+        EventDispatcher& operator=(const EventDispatcher& other) = delete;
+
+        // nullptr отключает события
+        void set_sink(std::shared_ptr<MT::EventSink> sink_);
+
+        bool is_enabled() const {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        // не блокируется: при переполненном буфере событие отбрасывается
+        void publish(MT::TaskEventType type, size_t task_id, std::string message = std::string());
+
+        // синхронно доставляет всё, что уже опубликовано
+        void flush();
+
+        size_t dropped_events() const;
+
+        // буферов потоков, ещё не освобождённых
+        size_t buffer_count();
+
+        ~EventDispatcher();
+    };
+}
@@ -0,0 +1,250 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "thread_pool.h"
+#include "run_file.h"
+#include "sort_kernels.h"
+#include "kway_merge.h"
+#include "pipeline.h"
+
+
+// Внешняя сортировка записей фиксированной длины, не помещающихся в память.
+// Вход режется на серии, каждая сортируется на всех потоках пула и пишется во временный файл;
+// пока одна серия сортируется и пишется, следующая уже читается с диска (MT::Pipeline на два токена).
+// Затем серии сливаются параллельно по диапазонам ключей (kway_merge.h); если серий больше,
+// чем допускает бюджет памяти на одно слияние, слияние идёт в несколько проходов.
+// Размер серии и число сливаемых за раз серий выводятся из бюджета памяти
+
+namespace MT {
+
+    struct ExternalSortOptions {
+        // память на буферы серий и слияния, байт
+        size_t memory_budget = size_t(256) << 20;
+        // здесь создаётся собственный каталог сортировки, удаляемый по её завершении
+        std::filesystem::path temp_dir = std::filesystem::temp_directory_path();
+        // серий на одно слияние; 0 - выводится из memory_budget
+        size_t merge_fan_in = 0;
+    };
+
+
+    struct ExternalSortStats {
+        uint64_t elements = 0;
+        size_t run_elements = 0;
+        size_t fan_in = 0;
+        size_t initial_runs = 0;
+        // проходов слияния, включая последний - в результат
+        size_t merge_passes = 0;
+    };
+
+
+    namespace detail {
+
+        // каталог, которого нет ни у одной другой сортировки, в том числе в других процессах
+        inline std::filesystem::path unique_sort_dir(const std::filesystem::path& base) {
+            static std::atomic<uint64_t> sequence{0};
+            static const std::string process_tag = std::to_string(std::random_device{}());
+            return base / ("mt_external_sort_" + process_tag + "_" + std::to_string(sequence.fetch_add(1)));
+        }
+
+
+        // удаляет каталог сортировки и при исключении
+        struct RemoveDirectory {
+            std::filesystem::path path;
+
+            ~RemoveDirectory() {
+                std::error_code ignored;
+                std::filesystem::remove_all(path, ignored);
+            }
+        };
+    }
+
+
+    // Сортировщик файлов серий (run_file.h) из элементов T. Ограничения на вызов sort - как
+    // у алгоритмов parallel.h: из задачи пула или из внешнего потока при запущенном пуле
+    template <typename T, typename Compare = std::less<>>
+    class ExternalSorter {
+        static_assert(std::is_trivially_copyable_v<T>, "external sort stores records as raw bytes");
+
+        // серий в памяти одновременно (токенов конвейера): одна читается, другая сортируется и пишется
+        static constexpr size_t run_buffers = 2;
+        // сортировке серии нужен буфер того же размера
+        static constexpr size_t sort_memory_factor = 2;
+        // окно упреждающего чтения каждой сливаемой серии
+        static constexpr size_t merge_window = size_t(1) << 20;
+        static constexpr size_t max_fan_in = 1024;
+
+        // ядра без сравнений применимы только к естественному порядку
+        static constexpr bool use_sort_kernel =
+            (std::is_same_v<Compare, std::less<>> || std::is_same_v<Compare, std::less<T>>) &&
+            MT::sort_kernel_for<T>() != MT::SortKernel::comparison;
+
+        MT::ThreadPool& pool;
+        MT::ExternalSortOptions options;
+        Compare comp;
+
+
+        void sort_run(std::vector<T>& run) {
+            if constexpr (use_sort_kernel) {
+                MT::parallel_sort_kernel(pool, std::span<T>(run));
+            } else {
+                MT::parallel_sort(pool, run.begin(), run.end(), comp);
+            }
+        }
+
+
+        struct PendingRun {
+            std::vector<T> values;
+            std::filesystem::path path;
+        };
+
+
+        // режет вход на отсортированные серии в dir конвейером: источник копирует очередную часть
+        // входа (здесь читаются его страницы), параллельная стадия сортирует и пишет её;
+        // одновременно в работе не больше run_buffers серий
+        std::vector<std::filesystem::path> make_runs(std::span<const T> input, const std::filesystem::path& dir) {
+            size_t length = run_elements();
+            std::vector<std::filesystem::path> runs;
+            size_t first = 0;
+
+            MT::Pipeline(pool, run_buffers).run(
+                [&]() -> std::optional<PendingRun> {
+                    if (first >= input.size()) {
+                        return std::nullopt;
+                    }
+                    std::span<const T> part = input.subspan(first, std::min(length, input.size() - first));
+                    first += part.size();
+                    runs.push_back(dir / ("run_0_" + std::to_string(runs.size()) + ".run"));
+                    return PendingRun{std::vector<T>(part.begin(), part.end()), runs.back()};
+                },
+                MT::parallel_stage([this](PendingRun run) {
+                    sort_run(run.values);
+                    MT::RunWriter<T> writer(run.path);
+                    writer.write(std::span<const T>(run.values));
+                    writer.close(true);
+                }));
+            return runs;
+        }
+
+
+        // частей параллельного слияния: по одной на поток пула, каждой нужен свой буфер писателя
+        size_t merge_parts() const {
+            return std::max<size_t>(1, pool.count_of_threads());
+        }
+
+
+        // fan_in при заданном числе частей слияния: окно чтения на каждую серию плюс буферы писателей частей
+        size_t fan_in_for(size_t parts) const {
+            if (options.merge_fan_in != 0) {
+                return std::max<size_t>(2, options.merge_fan_in);
+            }
+            size_t writers_memory = parts * MT::BlockFileWriter::buffer_size;
+            size_t available = options.memory_budget > writers_memory ? options.memory_budget - writers_memory : 0;
+            return std::clamp<size_t>(available / merge_window, 2, max_fan_in);
+        }
+
+
+        void merge(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& output, size_t parts) {
+            std::vector<MT::RunReader<T>> readers;
+            std::vector<std::span<const T>> runs;
+            uint64_t total = 0;
+            readers.reserve(inputs.size());
+            for (const std::filesystem::path& input : inputs) {
+                readers.emplace_back(input);
+                runs.push_back(readers.back().values());
+                total += runs.back().size();
+            }
+            MT::RunSlices<T> out(output, total);
+            MT::parallel_merge_runs(pool, runs, [&out](uint64_t first) { return out.slice(first); }, comp, parts);
+            out.close(true);
+        }
+
+     public:
+        ExternalSorter(MT::ThreadPool& pool_, MT::ExternalSortOptions options_ = {}, Compare comp_ = Compare()) :
+            pool(pool_), options(std::move(options_)), comp(std::move(comp_)) {}
+
+        // элементов в одной начальной серии
+        size_t run_elements() const {
+            return std::max<size_t>(1, options.memory_budget / (run_buffers * sort_memory_factor * sizeof(T)));
+        }
+
+        // серий на одно слияние при текущем числе потоков пула
+        size_t fan_in() const {
+            return fan_in_for(merge_parts());
+        }
+
+        // сортирует элементы в серию output
+        MT::ExternalSortStats sort(std::span<const T> input, const std::filesystem::path& output) {
+            MT::ExternalSortStats stats;
+            stats.elements = input.size();
+            stats.run_elements = run_elements();
+            // число частей фиксируется один раз: эластичный пул может поменять число потоков во время
+            // сортировки, а бюджет памяти fan_in рассчитан именно на столько писателей
+            size_t parts = merge_parts();
+            stats.fan_in = fan_in_for(parts);
+
+            detail::RemoveDirectory dir{detail::unique_sort_dir(options.temp_dir)};
+            std::filesystem::create_directories(dir.path);
+
+            std::vector<std::filesystem::path> runs = make_runs(input, dir.path);
+            stats.initial_runs = runs.size();
+
+            // промежуточные проходы: группы по fan_in серий сливаются в одну, пока все не сольются разом
+            while (runs.size() > stats.fan_in) {
+                ++stats.merge_passes;
+                std::vector<std::filesystem::path> merged;
+                for (size_t first = 0; first < runs.size(); first += stats.fan_in) {
+                    std::vector<std::filesystem::path> group(runs.begin() + first,
+                                                             runs.begin() + std::min(runs.size(), first + stats.fan_in));
+                    merged.push_back(dir.path / ("run_" + std::to_string(stats.merge_passes) + "_" +
+                                                 std::to_string(merged.size()) + ".run"));
+                    merge(group, merged.back(), parts);
+                    for (const std::filesystem::path& run : group) {
+                        std::filesystem::remove(run);
+                    }
+                }
+                runs = std::move(merged);
+            }
+
+            ++stats.merge_passes;
+            merge(runs, output, parts);
+            return stats;
+        }
+
+        // сортирует серию input в серию output; input может быть сколь угодно большим - он отображается в память.
+        // output может совпадать с input (в том числе через ссылку): тогда результат пишется во временный
+        // файл рядом и переименовывается в output, иначе запись усекла бы ещё читаемый вход
+        MT::ExternalSortStats sort(const std::filesystem::path& input, const std::filesystem::path& output) {
+            std::error_code ignored;
+            if (!std::filesystem::equivalent(input, output, ignored)) {
+                MT::RunReader<T> reader(input);
+                return sort(reader.values(), output);
+            }
+
+            // через ссылку заменяется сам файл, а не ссылка
+            std::filesystem::path target = std::filesystem::canonical(output);
+            std::filesystem::path temp = target;
+            temp += ".sorting";
+            MT::ExternalSortStats stats;
+            try {
+                {
+                    MT::RunReader<T> reader(input);
+                    stats = sort(reader.values(), temp);
+                }
+                std::filesystem::rename(temp, target);
+            } catch (...) {
+                std::filesystem::remove(temp, ignored);
+                throw;
+            }
+            return stats;
+        }
+    };
+}
@@ -0,0 +1,103 @@
+#include "job.h"
+#include <mutex>
+#include <ranges>
+#include <vector>
+
+
+namespace {
+	// размер пачки узлов, которой поток обменивается с общим списком
+	const size_t batch_size = 64;
+
+
+	// Общий список пачек свободных узлов. Создаётся один раз и никогда не разрушается,
+	// чтобы потоки, завершающиеся после main, могли вернуть в него свои узлы
+	struct SharedJobs {
+		std::mutex mutex;
+		std::vector<MT::Job*> batches;
+	};
+
+	SharedJobs& shared_jobs() {
+		static SharedJobs* jobs = new SharedJobs();
+		return *jobs;
+	}
+
+
+	// Свободные узлы текущего потока, односвязный список через Job::next
+	struct LocalJobs {
+		MT::Job* head = nullptr;
+		size_t count = 0;
+
+		// отрезает batch_size узлов с головы списка
+		MT::Job* cut_batch() {
+			MT::Job* batch = head;
+			MT::Job* last = head;
+			for ([[maybe_unused]] size_t i : std::ranges::iota_view(static_cast<size_t>(1), batch_size)) {
+				last = last->next;
+			}
+			head = last->next;
+			last->next = nullptr;
+			count -= batch_size;
+			return batch;
+		}
+
+		~LocalJobs() {
+			SharedJobs& shared = shared_jobs();
+			std::lock_guard<std::mutex> lock(shared.mutex);
+			while (count >= batch_size) {
+				shared.batches.push_back(cut_batch());
+			}
+			while (head != nullptr) {
+				MT::Job* job = head;
+				head = head->next;
+				delete job;
+			}
+		}
+	};
+
+	thread_local LocalJobs local_jobs;
+}
+
+
+MT::Job* MT::JobPool::allocate() {
+	if (local_jobs.head == nullptr) {
+		SharedJobs& shared = shared_jobs();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		if (!shared.batches.empty()) {
+			local_jobs.head = shared.batches.back();
+			local_jobs.count = batch_size;
+			shared.batches.pop_back();
+		}
+	}
+
+	if (local_jobs.head == nullptr) {
+		return new MT::Job();
+	}
+
+	MT::Job* job = local_jobs.head;
+	local_jobs.head = job->next;
+	--local_jobs.count;
+	job->next = nullptr;
+	return job;
+}
+
+
+void MT::JobPool::release(MT::Job* job) {
+	job->fn.reset();
+	job->task_id = 0;
+	job->task = nullptr;
+	job->listener = nullptr;
+	job->priority = MT::TaskPriority::normal;
+	job->node = MT::any_node;
+
+	job->next = local_jobs.head;
+	local_jobs.head = job;
+	++local_jobs.count;
+
+	// у потока скопилось слишком много узлов - отдаём пачку тем, кто их выделяет
+	if (local_jobs.count >= 2 * batch_size) {
+		MT::Job* batch = local_jobs.cut_batch();
+		SharedJobs& shared = shared_jobs();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		shared.batches.push_back(batch);
+	}
+}
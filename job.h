@@ -0,0 +1,112 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include "task_function.h"
+
+
+namespace MT {
+
+    class Task;
+
+
+    // Приоритет задачи: потоки сначала берут задачи с более высоким приоритетом
+    enum class TaskPriority : uint8_t {
+        high,
+        normal,
+        low
+    };
+
+    constexpr size_t priority_levels = 3;
+
+    // работа может выполняться на любом узле NUMA
+    constexpr size_t any_node = static_cast<size_t>(-1);
+
+
+    // Получатель уведомления о выполнении работы (TaskGroup, узел TaskGraph).
+    // Вызывается потоком пула до того, как работа будет учтена в счётчиках пула,
+    // поэтому может добавить в пул следующие задачи до того, как wait() пула проснётся
+    class JobListener {
+     public:
+        // error - исключение работы или nullptr при успешном выполнении
+        virtual void on_job_finished(std::exception_ptr error) = 0;
+
+     protected:
+        ~JobListener() = default;
+    };
+
+
+    // Единица работы в очередях пула. Узлы переиспользуются через JobPool,
+    // поэтому в установившемся режиме постановка задачи не выделяет память
+    struct Job {
+        MT::TaskFunction fn;
+        size_t task_id = 0;
+
+        // задача-наследник Task, если работа добавлена через add_task (для описания в журнале)
+        MT::Task* task = nullptr;
+
+        // кому сообщить о выполнении работы
+        MT::JobListener* listener = nullptr;
+
+        MT::TaskPriority priority = MT::TaskPriority::normal;
+
+        // предпочтительный узел NUMA (при ThreadPlacement::numa_nodes)
+        size_t node = MT::any_node;
+
+        // момент постановки в очередь, для метрик времени ожидания
+        std::chrono::steady_clock::time_point enqueue_time;
+
+        // следующий узел в очереди пула или в списке свободных узлов
+        Job* next = nullptr;
+    };
+
+
+    // Очередь узлов Job, односвязный список через Job::next.
+    // Синхронизация - на стороне владельца
+    struct JobList {
+        MT::Job* head = nullptr;
+        MT::Job* tail = nullptr;
+
+        bool empty() const {
+            return head == nullptr;
+        }
+
+        // присоединяет уже связанную цепочку first..last за O(1)
+        void append(MT::Job* first, MT::Job* last) {
+            last->next = nullptr;
+            if (tail != nullptr) {
+                tail->next = first;
+            } else {
+                head = first;
+            }
+            tail = last;
+        }
+
+        void push(MT::Job* job) {
+            append(job, job);
+        }
+
+        MT::Job* pop() {
+            MT::Job* job = head;
+            if (job != nullptr) {
+                head = job->next;
+                if (head == nullptr) {
+                    tail = nullptr;
+                }
+                job->next = nullptr;
+            }
+            return job;
+        }
+    };
+
+
+    // Пул узлов Job: у каждого потока свой список свободных узлов,
+    // излишки передаются в общий список пачками под мьютексом
+    struct JobPool {
+        static MT::Job* allocate();
+
+        // разрушает работу и возвращает узел в пул
+        static void release(MT::Job* job);
+    };
+}
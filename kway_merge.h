@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+#include "parallel.h"
+
+
+// Слияние k упорядоченных серий. Последовательно - турнирным деревом проигравших (loser tree):
+// после выдачи элемента пересчитывается только путь от его листа к корню, log2(k) сравнений,
+// и каждая серия читается подряд от начала к концу (для отображённых файлов - крупными
+// блоками упреждающего чтения). Параллельно - по диапазонам ключей: ключи-разделители выбираются
+// по равномерной выборке из всех серий, границы частей в каждой серии находятся бинарным поиском,
+// и каждый поток сливает свой диапазон ключей в свою часть результата
+
+namespace MT {
+
+    // Турнирное дерево проигравших над упорядоченными сериями. Слияние устойчиво:
+    // из равных элементов раньше выдаётся элемент серии с меньшим номером
+    template <typename T, typename Compare = std::less<>>
+    class LoserTree {
+        std::vector<std::span<const T>> runs;
+        // losers[0] - номер серии-победителя, losers[1..k) - проигравшие во внутренних узлах;
+        // лист серии i - узел k + i
+        std::vector<size_t> losers;
+        size_t k;
+        Compare comp;
+
+        // элемент серии a идёт раньше элемента серии b; исчерпанная серия проигрывает всем
+        bool before(size_t a, size_t b) const {
+            if (runs[a].empty() || runs[b].empty()) {
+                return runs[b].empty() && (!runs[a].empty() || a < b);
+            }
+            if (comp(runs[a].front(), runs[b].front())) {
+                return true;
+            }
+            if (comp(runs[b].front(), runs[a].front())) {
+                return false;
+            }
+            return a < b;
+        }
+
+     public:
+        explicit LoserTree(std::vector<std::span<const T>> runs_, Compare comp_ = Compare()) :
+                runs(std::move(runs_)), losers(std::max<size_t>(1, runs.size())), k(runs.size()), comp(std::move(comp_)) {
+            if (k == 0) {
+                runs.emplace_back();
+                k = 1;
+            }
+            // победители поддеревьев снизу вверх, в узлах остаются проигравшие
+            std::vector<size_t> winners(2 * k);
+            for (size_t i : std::ranges::iota_view(size_t(0), k)) {
+                winners[k + i] = i;
+            }
+            for (size_t node = k - 1; node >= 1; --node) {
+                size_t left = winners[2 * node];
+                size_t right = winners[2 * node + 1];
+                bool left_wins = before(left, right);
+                winners[node] = left_wins ? left : right;
+                losers[node] = left_wins ? right : left;
+            }
+            losers[0] = k == 1 ? 0 : winners[1];
+        }
+
+        bool empty() const {
+            return runs[losers[0]].empty();
+        }
+
+        const T& top() const {
+            return runs[losers[0]].front();
+        }
+
+        // номер серии, из которой взят top()
+        size_t top_run() const {
+            return losers[0];
+        }
+
+        // убирает top() и переигрывает путь от его листа к корню
+        void pop() {
+            size_t winner = losers[0];
+            runs[winner] = runs[winner].subspan(1);
+            for (size_t node = (winner + k) / 2; node >= 1; node /= 2) {
+                if (before(losers[node], winner)) {
+                    std::swap(losers[node], winner);
+                }
+            }
+            losers[0] = winner;
+        }
+    };
+
+
+    // сливает серии последовательно: output.write(const T&) для каждого элемента по порядку
+    template <typename T, typename Output, typename Compare = std::less<>>
+    void merge_runs(std::vector<std::span<const T>> runs, Output& output, Compare comp = Compare()) {
+        MT::LoserTree<T, Compare> tree(std::move(runs), std::move(comp));
+        while (!tree.empty()) {
+            output.write(tree.top());
+            tree.pop();
+        }
+    }
+
+
+    // Границы частей параллельного слияния: bounds[j][r] - начало части j в серии r,
+    // bounds[parts][r] - длина серии r. Часть j содержит ключи из [splitter(j-1), splitter(j)),
+    // поэтому части не пересекаются по ключам и их конкатенация упорядочена. При большом числе
+    // равных ключей части могут получиться неравными: одинаковые ключи не разделяются
+    template <typename T, typename Compare = std::less<>>
+    std::vector<std::vector<size_t>> partition_runs(const std::vector<std::span<const T>>& runs, size_t parts,
+                                                    const Compare& comp = Compare()) {
+        // выборок на часть: чем больше, тем ровнее части
+        constexpr size_t oversampling = 32;
+
+        size_t total = 0;
+        for (const auto& run : runs) {
+            total += run.size();
+        }
+        parts = std::max<size_t>(1, std::min(parts, total));
+
+        // элементы с шагом stride по всем сериям: каждая выборка представляет stride элементов,
+        // поэтому квантили выборки приближают квантили всего множества
+        std::vector<T> samples;
+        size_t stride = std::max<size_t>(1, total / (parts * oversampling));
+        for (const auto& run : runs) {
+            for (size_t i = stride / 2; i < run.size(); i += stride) {
+                samples.push_back(run[i]);
+            }
+        }
+        std::sort(samples.begin(), samples.end(), comp);
+        // коротким сериям может не достаться выборок - тогда и частей меньше
+        parts = std::max<size_t>(1, std::min(parts, samples.size()));
+
+        std::vector<std::vector<size_t>> bounds(parts + 1, std::vector<size_t>(runs.size(), 0));
+        for (size_t j : std::ranges::iota_view(size_t(1), parts)) {
+            const T& splitter = samples[j * samples.size() / parts];
+            for (size_t r : std::ranges::iota_view(size_t(0), runs.size())) {
+                auto position = std::lower_bound(runs[r].begin(), runs[r].end(), splitter, comp);
+                bounds[j][r] = static_cast<size_t>(position - runs[r].begin());
+            }
+        }
+        for (size_t r : std::ranges::iota_view(size_t(0), runs.size())) {
+            bounds[parts][r] = runs[r].size();
+        }
+        return bounds;
+    }
+
+
+    // Параллельное слияние серий в parts частей (0 - по одной на поток пула).
+    // make_output(first) возвращает писателя части результата, начинающейся с элемента first:
+    // write(const T&) и close(). Части пишутся одновременно разными потоками.
+    // Ограничения на вызов - как у алгоритмов parallel.h
+    template <typename T, typename OutputFactory, typename Compare = std::less<>>
+    void parallel_merge_runs(MT::ThreadPool& pool, const std::vector<std::span<const T>>& runs,
+                             OutputFactory&& make_output, Compare comp = Compare(), size_t parts = 0) {
+        if (parts == 0) {
+            parts = pool.count_of_threads();
+        }
+        auto bounds = MT::partition_runs(runs, parts, comp);
+        parts = bounds.size() - 1;
+
+        // начало части в результате - сколько элементов всех серий лежит левее неё
+        std::vector<uint64_t> first(parts, 0);
+        for (size_t j : std::ranges::iota_view(size_t(0), parts)) {
+            for (size_t position : bounds[j]) {
+                first[j] += position;
+            }
+        }
+
+        MT::parallel_for(pool, std::ranges::iota_view(size_t(0), parts), [&](size_t j) {
+            std::vector<std::span<const T>> part_runs;
+            part_runs.reserve(runs.size());
+            for (size_t r : std::ranges::iota_view(size_t(0), runs.size())) {
+                part_runs.push_back(runs[r].subspan(bounds[j][r], bounds[j + 1][r] - bounds[j][r]));
+            }
+            auto output = make_output(first[j]);
+            MT::merge_runs(std::move(part_runs), output, comp);
+            output.close();
+        }, 1);
+    }
+}
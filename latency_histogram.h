@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ranges>
+
+
+namespace MT {
+
+    // Перцентили одной гистограммы
+    struct LatencyPercentiles {
+        uint64_t count = 0;
+        std::chrono::nanoseconds mean{0};
+        std::chrono::nanoseconds p50{0};
+        std::chrono::nanoseconds p90{0};
+        std::chrono::nanoseconds p99{0};
+        std::chrono::nanoseconds p999{0};
+        std::chrono::nanoseconds max{0};
+    };
+
+
+    // Гистограмма длительностей в наносекундах с лог-линейными корзинами (как в HdrHistogram):
+    // каждая степень двойки делится на sub_buckets равных корзин, поэтому перцентиль
+    // отличается от точного значения не больше чем на 1/sub_buckets. Запись не блокируется
+    class LatencyHistogram {
+     public:
+        static constexpr size_t sub_bucket_bits = 3;
+        static constexpr size_t sub_buckets = size_t(1) << sub_bucket_bits;
+        // значения меньше sub_buckets хранятся точно, дальше - по sub_buckets корзин на степень двойки
+        static constexpr size_t buckets_count = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+     private:
+        std::array<std::atomic<uint64_t>, buckets_count> buckets{};
+        std::atomic<uint64_t> total_count{0};
+        std::atomic<uint64_t> total_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+
+        static size_t bucket_of(uint64_t ns) {
+            if (ns < sub_buckets) {
+                return static_cast<size_t>(ns);
+            }
+            size_t exponent = std::bit_width(ns) - 1;
+            size_t sub_bucket = static_cast<size_t>(ns >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+            return (exponent - sub_bucket_bits + 1) * sub_buckets + sub_bucket;
+        }
+
+        // наибольшее значение, попадающее в корзину
+        static uint64_t upper_bound_of(size_t bucket) {
+            if (bucket < sub_buckets) {
+                return bucket;
+            }
+            size_t exponent = bucket / sub_buckets + sub_bucket_bits - 1;
+            uint64_t width = uint64_t(1) << (exponent - sub_bucket_bits);
+            uint64_t lower = (sub_buckets + bucket % sub_buckets) * width;
+            return lower + (width - 1);
+        }
+
+     public:
+        void record(std::chrono::nanoseconds duration) {
+            uint64_t ns = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+            buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+            total_count.fetch_add(1, std::memory_order_relaxed);
+            total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+            uint64_t current_max = max_ns.load(std::memory_order_relaxed);
+            while (current_max < ns && !max_ns.compare_exchange_weak(current_max, ns, std::memory_order_relaxed)) {}
+        }
+
+        // запись в гистограмму, которую пишет только один поток (гистограмма потока пула):
+        // вместо атомарных read-modify-write - обычные чтение и запись, читатели по-прежнему
+        // видят согласованные по отдельности счётчики
+        void record_single_writer(std::chrono::nanoseconds duration) {
+            uint64_t ns = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+            std::atomic<uint64_t>& bucket = buckets[bucket_of(ns)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            total_count.store(total_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            total_ns.store(total_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if (max_ns.load(std::memory_order_relaxed) < ns) {
+                max_ns.store(ns, std::memory_order_relaxed);
+            }
+        }
+
+        // добавляет записи другой гистограммы (сведение гистограмм потоков)
+        void add(const LatencyHistogram& other) {
+            for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), buckets_count)) {
+                uint64_t bucket = other.buckets[i].load(std::memory_order_relaxed);
+                if (bucket != 0) {
+                    buckets[i].fetch_add(bucket, std::memory_order_relaxed);
+                }
+            }
+            total_count.fetch_add(other.total_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            total_ns.fetch_add(other.total_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+            uint64_t other_max = other.max_ns.load(std::memory_order_relaxed);
+            uint64_t current_max = max_ns.load(std::memory_order_relaxed);
+            while (current_max < other_max && !max_ns.compare_exchange_weak(current_max, other_max, std::memory_order_relaxed)) {}
+        }
+
+        uint64_t count() const {
+            return total_count.load(std::memory_order_relaxed);
+        }
+
+        std::chrono::nanoseconds mean() const {
+            uint64_t current_count = count();
+            return std::chrono::nanoseconds(current_count == 0 ? 0 : total_ns.load(std::memory_order_relaxed) / current_count);
+        }
+
+        std::chrono::nanoseconds max() const {
+            return std::chrono::nanoseconds(max_ns.load(std::memory_order_relaxed));
+        }
+
+        // верхняя граница корзины, в которую попадает доля q (от 0 до 1) записей
+        std::chrono::nanoseconds percentile(double q) const {
+            uint64_t current_count = count();
+            if (current_count == 0) {
+                return std::chrono::nanoseconds(0);
+            }
+            uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * current_count)));
+            uint64_t seen = 0;
+            for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), buckets_count)) {
+                seen += buckets[i].load(std::memory_order_relaxed);
+                if (seen >= target) {
+                    return std::chrono::nanoseconds(std::min(upper_bound_of(i), max_ns.load(std::memory_order_relaxed)));
+                }
+            }
+            return max();
+        }
+
+        MT::LatencyPercentiles percentiles() const {
+            MT::LatencyPercentiles result;
+            result.count = count();
+            result.mean = mean();
+            result.p50 = percentile(0.5);
+            result.p90 = percentile(0.9);
+            result.p99 = percentile(0.99);
+            result.p999 = percentile(0.999);
+            result.max = max();
+            return result;
+        }
+    };
+}
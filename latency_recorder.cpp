@@ -0,0 +1,92 @@
+#include "latency_recorder.h"
+#include <cstdlib>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+
+void MT::LatencyRecorder::Histograms::add(const Histograms& other) {
+	queue_wait.add(other.queue_wait);
+	execution.add(other.execution);
+	end_to_end.add(other.end_to_end);
+}
+
+
+MT::LatencyBreakdown MT::LatencyRecorder::Histograms::breakdown() const {
+	MT::LatencyBreakdown result;
+	result.queue_wait = queue_wait.percentiles();
+	result.execution = execution.percentiles();
+	result.end_to_end = end_to_end.percentiles();
+	return result;
+}
+
+
+void MT::LatencyRecorder::record(const std::type_info* task_type, MT::TaskPriority priority,
+								 std::chrono::nanoseconds queue_wait, std::chrono::nanoseconds execution) {
+	wait_by_priority[static_cast<size_t>(priority)].record_single_writer(queue_wait);
+	this->execution.record_single_writer(execution);
+	end_to_end.record_single_writer(queue_wait + execution);
+
+	Histograms* type_histograms = &callables;
+	if (task_type != nullptr) {
+		auto it = by_type.find(std::type_index(*task_type));
+		if (it != by_type.end()) {
+			type_histograms = it->second.get();
+		} else {
+			std::lock_guard<std::mutex> lock(types_mutex);
+			type_histograms = by_type.emplace(std::type_index(*task_type), std::make_unique<Histograms>()).first->second.get();
+		}
+	}
+	type_histograms->queue_wait.record_single_writer(queue_wait);
+	type_histograms->execution.record_single_writer(execution);
+	type_histograms->end_to_end.record_single_writer(queue_wait + execution);
+}
+
+
+void MT::LatencyRecorder::add_priority_wait(MT::TaskPriority priority, MT::LatencyHistogram& total) const {
+	total.add(wait_by_priority[static_cast<size_t>(priority)]);
+}
+
+
+void MT::LatencyRecorder::add_overall(Histograms& total) const {
+	for (const MT::LatencyHistogram& wait : wait_by_priority) {
+		total.queue_wait.add(wait);
+	}
+	total.execution.add(execution);
+	total.end_to_end.add(end_to_end);
+}
+
+
+void MT::LatencyRecorder::add_by_type(std::map<std::string, std::unique_ptr<Histograms>>& total) const {
+	auto add_group = [&total](const std::string& name, const Histograms& histograms) {
+		if (histograms.end_to_end.count() == 0) {
+			return;
+		}
+		std::unique_ptr<Histograms>& group = total[name];
+		if (!group) {
+			group = std::make_unique<Histograms>();
+		}
+		group->add(histograms);
+	};
+
+	add_group("callable", callables);
+	std::lock_guard<std::mutex> lock(types_mutex);
+	for (const auto& [type, histograms] : by_type) {
+		add_group(MT::type_name(type.name()), *histograms);
+	}
+}
+
+
+std::string MT::type_name(const char* mangled_name) {
+#ifdef __GNUG__
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(mangled_name, nullptr, nullptr, &status);
+	if (status == 0 && demangled != nullptr) {
+		std::string result(demangled);
+		std::free(demangled);
+		return result;
+	}
+#endif
+	return mangled_name;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include "job.h"
+#include "latency_histogram.h"
+
+
+namespace MT {
+
+    // Задержки одной группы задач
+    struct LatencyBreakdown {
+        // от добавления в пул до начала выполнения
+        MT::LatencyPercentiles queue_wait;
+        // выполнение
+        MT::LatencyPercentiles execution;
+        // от добавления в пул до завершения
+        MT::LatencyPercentiles end_to_end;
+    };
+
+
+    // Результат ThreadPool::latency_snapshot
+    struct LatencySnapshot {
+        MT::LatencyBreakdown overall;
+        // по типам задач-наследников Task; вызываемые объекты собраны под именем "callable"
+        std::map<std::string, MT::LatencyBreakdown> by_task_type;
+    };
+
+
+    // Гистограммы задержек одного потока пула. Пишет только сам поток, без блокировок
+    // и атомарных read-modify-write;
+    // ThreadPool::latency_snapshot сводит гистограммы всех потоков в момент запроса
+    class LatencyRecorder {
+     public:
+        struct Histograms {
+            MT::LatencyHistogram queue_wait;
+            MT::LatencyHistogram execution;
+            MT::LatencyHistogram end_to_end;
+
+            void add(const Histograms& other);
+
+            MT::LatencyBreakdown breakdown() const;
+        };
+
+     private:
+        // ожидание в очереди по уровням приоритета, для ThreadPool::priority_stats
+        std::array<MT::LatencyHistogram, MT::priority_levels> wait_by_priority;
+
+        // общее ожидание в очереди сводится из wait_by_priority
+        MT::LatencyHistogram execution;
+        MT::LatencyHistogram end_to_end;
+
+        Histograms callables;
+
+        // поиск - только владельцем и без блокировки (узлы unordered_map не перемещаются),
+        // вставка владельцем и обход читателем - под types_mutex
+        mutable std::mutex types_mutex;
+        std::unordered_map<std::type_index, std::unique_ptr<Histograms>> by_type;
+
+     public:
+        // task_type - динамический тип задачи-наследника Task или nullptr для вызываемого объекта
+        void record(const std::type_info* task_type, MT::TaskPriority priority,
+                    std::chrono::nanoseconds queue_wait, std::chrono::nanoseconds execution);
+
+        void add_priority_wait(MT::TaskPriority priority, MT::LatencyHistogram& total) const;
+
+        void add_overall(Histograms& total) const;
+
+        void add_by_type(std::map<std::string, std::unique_ptr<Histograms>>& total) const;
+    };
+
+
+    // читаемое имя типа по std::type_info::name() (без искажения имён компилятором)
+    std::string type_name(const char* mangled_name);
+}
@@ -13,12 +13,30 @@ TaskType parseType(const std::string& cmd) {
     if (cmd == "wait_echo") return TaskType::WaitEcho;
     if (cmd == "sort_big_vec") return TaskType::SortBigVec;
 	if (cmd == "search_in_file") return TaskType::SearchInALargeFile;
+	if (cmd == "search_words_in_file") return TaskType::SearchWordsInALargeFile;
     throw std::runtime_error("Unknown command");
 }
 
 
+// перцентили в микросекундах: p50 / p90 / p99 / p999
+void print_percentiles(const char* name, const MT::LatencyPercentiles& latency) {
+	auto us = [](std::chrono::nanoseconds ns) { return ns.count() / 1000.0; };
+	std::cout << "  " << name << ": " << us(latency.p50) << " / " << us(latency.p90) << " / "
+			  << us(latency.p99) << " / " << us(latency.p999) << " us\n";
+}
+
+
+void print_latency(const std::string& group, const MT::LatencyBreakdown& latency) {
+	std::cout << group << " (" << latency.end_to_end.count << " tasks), p50 / p90 / p99 / p999:\n";
+	print_percentiles("queue wait", latency.queue_wait);
+	print_percentiles("execution", latency.execution);
+	print_percentiles("end to end", latency.end_to_end);
+}
+
+
 int main() {
     MT::ThreadPool thread_pool(3);
+	thread_pool.set_event_sink(std::make_shared<MT::ConsoleEventSink>());
 
     std::cout << "Server started. Enter commands:\n";
   	std::cout << "compute_primes N\n"
@@ -27,9 +45,12 @@ int main() {
                  "result ID\n"
 				 "sort_big_vec\n"
 				 "search_in_file\n"
+				 "search_words_in_file PATH WORD...\n"
 				 "pause - to pause working server\n"
 				 "start - to resume working server\n"
 				 "count working threads - press '?'\n"
+				 "latency - task latency percentiles\n"
+				 "stats - pool counters\n"
                  "exit\n";
 	
 	std::string input_data;
@@ -45,13 +66,27 @@ int main() {
 			thread_pool.get_result(cur_id);
 		} else if (command == "?") {
 			std::cout << thread_pool.count_working_threads() << '\n';
+		} else if (command == "latency") {
+			MT::LatencySnapshot snapshot = thread_pool.latency_snapshot();
+			print_latency("all tasks", snapshot.overall);
+			for (const auto& [type, latency] : snapshot.by_task_type) {
+				print_latency(type, latency);
+			}
+		} else if (command == "stats") {
+			MT::PoolStats stats = thread_pool.stats();
+			std::cout << "submitted " << stats.submitted << ", completed " << stats.completed
+					  << ", failed " << stats.failed << ", queued " << stats.queue_depth << '\n'
+					  << "threads " << stats.threads << " (working " << stats.working_threads
+					  << "), steals " << stats.steals << ", lock contentions " << stats.lock_contentions << '\n';
+			for (const MT::WorkerStats& worker : stats.workers) {
+				std::cout << "  thread " << worker.index << ": executed " << worker.executed
+						  << ", busy " << std::chrono::duration_cast<std::chrono::milliseconds>(worker.busy_time).count() << " ms\n";
+			}
 		} else if (command == "pause") {
 			thread_pool.pause();
 		} else if (command == "start") {
 			thread_pool.start();
-		} else if (command == "!") {
-			std::cout << thread_pool.count_waiting_threads() << '\n';
-		}else {
+		} else {
 			try {
 				TaskType type = parseType(command);
 				std::string data;
@@ -80,6 +115,13 @@ int main() {
 					std::cin.get();
 					std::shared_ptr test{std::make_shared<SearchInALargeFile>(path_to_file, phrase)};
 					thread_pool.add_task(std::move(test));
+				} else if (type == TaskType::SearchWordsInALargeFile) {
+					std::istringstream iss(data);
+					std::string path_to_file;
+					iss >> path_to_file;
+					std::vector<std::string> words(std::istream_iterator<std::string>(iss), {});
+					std::shared_ptr test{std::make_shared<SearchWordsInALargeFile>(path_to_file, std::move(words))};
+					thread_pool.add_task(std::move(test));
 				}
 		    } catch (std::exception& e) {
 				std::cout << "Error: " << e.what() << '\n';
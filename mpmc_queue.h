@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace MT {
+
+    // Ограниченная lock-free очередь для многих производителей и многих потребителей
+    // (кольцевой буфер с номером последовательности в каждой ячейке, схема Д. Вьюкова).
+    // Ёмкость округляется вверх до степени двойки.
+    template <typename T>
+    class BoundedMPMCQueue {
+        struct alignas(64) Cell {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+        std::unique_ptr<Cell[]> buffer;
+        const size_t mask;
+
+        alignas(64) std::atomic<size_t> enqueue_pos;
+        alignas(64) std::atomic<size_t> dequeue_pos;
+
+        static size_t round_up(size_t capacity) {
+            size_t result = 2;
+            while (result < capacity) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+     public:
+        explicit BoundedMPMCQueue(size_t capacity) :
+                buffer(new Cell[round_up(capacity)]), mask(round_up(capacity) - 1), enqueue_pos(0), dequeue_pos(0) {
+            for (size_t i = 0; i <= mask; ++i) {
+                buffer[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        BoundedMPMCQueue(const BoundedMPMCQueue& other) = delete;
+        BoundedMPMCQueue& operator=(const BoundedMPMCQueue& other) = delete;
+
+        // false, если очередь заполнена
+        bool try_push(T value) {
+            size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &buffer[pos & mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            cell->data = std::move(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // false, если очередь пуста
+        bool try_pop(T& value) {
+            size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+            Cell* cell;
+            while (true) {
+                cell = &buffer[pos & mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            value = std::move(cell->data);
+            cell->sequence.store(pos + mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const {
+            return mask + 1;
+        }
+
+        // приблизительный размер, точен только в отсутствие конкурентных операций
+        size_t size() const {
+            size_t enqueued = enqueue_pos.load(std::memory_order_relaxed);
+            size_t dequeued = dequeue_pos.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+    };
+}
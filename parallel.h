@@ -0,0 +1,148 @@
+#pragma once
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <utility>
+#include "thread_pool.h"
+#include "task_group.h"
+
+
+// Параллельные алгоритмы поверх ThreadPool. Диапазон рекурсивно делится пополам, пока часть
+// больше порции (grain): правая половина уходит в пул через TaskGroup, левую обрабатывает
+// текущий поток. Ожидающий поток пула выполняет задачи из очередей, поэтому алгоритмы можно
+// вызывать и из задач пула. Вызов из потока вне пула блокирует его до завершения, пул при
+// этом должен быть запущен (start()).
+//
+// grain == 0 - порция подбирается автоматически: около auto_chunks_per_thread частей на поток.
+// Границы частей зависят только от длины диапазона и порции (при автоматическом подборе - ещё и
+// от числа потоков пула), а частичные результаты сводятся слева направо, поэтому
+// parallel_reduce с ассоциативной операцией даёт тот же результат, что и последовательный проход
+
+namespace MT {
+
+    namespace detail {
+
+        // частей на поток при автоматическом подборе порции: запас на неравномерную нагрузку
+        inline constexpr size_t auto_chunks_per_thread = 8;
+
+        inline size_t resolve_grain(MT::ThreadPool& pool, size_t size, size_t grain) {
+            if (grain != 0) {
+                return grain;
+            }
+            size_t chunks = std::max<size_t>(1, pool.count_of_threads()) * auto_chunks_per_thread;
+            return std::max<size_t>(1, size / chunks);
+        }
+
+
+        // вызывает leaf(first, last) для частей [first, last) не длиннее grain
+        template <typename Leaf>
+        void split(MT::ThreadPool& pool, size_t first, size_t last, size_t grain, const Leaf& leaf) {
+            if (last - first <= grain) {
+                leaf(first, last);
+                return;
+            }
+            size_t middle = first + (last - first) / 2;
+            MT::TaskGroup right(pool);
+            right.run([&pool, middle, last, grain, &leaf]() { split(pool, middle, last, grain, leaf); });
+            split(pool, first, middle, grain, leaf);
+            right.wait();
+        }
+
+
+        // свёртка частей: результат левой половины всегда стоит слева от результата правой
+        template <typename T, typename Leaf, typename Reduce>
+        T split_reduce(MT::ThreadPool& pool, size_t first, size_t last, size_t grain, const Leaf& leaf, const Reduce& reduce) {
+            if (last - first <= grain) {
+                return leaf(first, last);
+            }
+            size_t middle = first + (last - first) / 2;
+            std::optional<T> right_result;
+            MT::TaskGroup right(pool);
+            right.run([&]() { right_result.emplace(split_reduce<T>(pool, middle, last, grain, leaf, reduce)); });
+            T left_result = split_reduce<T>(pool, first, middle, grain, leaf, reduce);
+            right.wait();
+            return reduce(std::move(left_result), std::move(*right_result));
+        }
+    }
+
+
+    // body(element) для каждого элемента диапазона; индексы - через std::views::iota(first, last)
+    template <std::ranges::random_access_range Range, typename Body>
+        requires std::ranges::sized_range<Range>
+    void parallel_for(MT::ThreadPool& pool, Range&& range, Body&& body, size_t grain = 0) {
+        auto begin = std::ranges::begin(range);
+        size_t size = static_cast<size_t>(std::ranges::size(range));
+        if (size == 0) {
+            return;
+        }
+        detail::split(pool, 0, size, detail::resolve_grain(pool, size, grain), [begin, &body](size_t first, size_t last) {
+            for (size_t i : std::ranges::iota_view(first, last)) {
+                body(begin[i]);
+            }
+        });
+    }
+
+
+    // свёртка reduce(T, T) -> T элементов, приведённых к T; identity - нейтральный элемент
+    template <std::ranges::random_access_range Range, typename T, typename Reduce>
+        requires std::ranges::sized_range<Range>
+    T parallel_reduce(MT::ThreadPool& pool, Range&& range, T identity, Reduce&& reduce, size_t grain = 0) {
+        auto begin = std::ranges::begin(range);
+        size_t size = static_cast<size_t>(std::ranges::size(range));
+        if (size == 0) {
+            return identity;
+        }
+        auto leaf = [begin, &identity, &reduce](size_t first, size_t last) {
+            T partial = identity;
+            for (size_t i : std::ranges::iota_view(first, last)) {
+                partial = reduce(std::move(partial), static_cast<T>(begin[i]));
+            }
+            return partial;
+        };
+        return detail::split_reduce<T>(pool, 0, size, detail::resolve_grain(pool, size, grain), leaf, reduce);
+    }
+
+
+    // output[i] = op(input[i]); output - начало диапазона произвольного доступа не короче input,
+    // возвращает итератор за последним записанным элементом
+    template <std::ranges::random_access_range Range, std::random_access_iterator Output, typename Op>
+        requires std::ranges::sized_range<Range>
+    Output parallel_transform(MT::ThreadPool& pool, Range&& input, Output output, Op&& op, size_t grain = 0) {
+        auto begin = std::ranges::begin(input);
+        size_t size = static_cast<size_t>(std::ranges::size(input));
+        if (size != 0) {
+            detail::split(pool, 0, size, detail::resolve_grain(pool, size, grain), [begin, output, &op](size_t first, size_t last) {
+                for (size_t i : std::ranges::iota_view(first, last)) {
+                    output[i] = op(begin[i]);
+                }
+            });
+        }
+        return output + size;
+    }
+
+
+    // выполняет все функции параллельно: все, кроме последней, - в пуле, последнюю - текущий поток.
+    // Если функции выбросили исключения, после завершения всех пробрасывается одно из них
+    template <typename... Functions>
+        requires (std::is_invocable_v<Functions&> && ...)
+    void parallel_invoke(MT::ThreadPool& pool, Functions&&... functions) {
+        static_assert(sizeof...(Functions) != 0, "parallel_invoke needs at least one function");
+        MT::TaskGroup group(pool);
+        auto all = std::forward_as_tuple(functions...);
+        constexpr size_t last = sizeof...(Functions) - 1;
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (group.run([&function = std::get<I>(all)]() { function(); }), ...);
+        }(std::make_index_sequence<last>());
+        try {
+            std::get<last>(all)();
+        } catch (...) {
+            // ошибку последней функции пробрасываем, дождавшись остальных
+            try {
+                group.wait();
+            } catch (...) {}
+            throw;
+        }
+        group.wait();
+    }
+}
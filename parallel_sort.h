@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+#include "parallel.h"
+
+
+// Параллельная сортировка слиянием: половины сортируются параллельно, а слияние само делится
+// на независимые части - середина большей последовательности и её позиция в меньшей
+// (бинарным поиском) разбивают слияние на два, которые выполняются параллельно.
+// Поэтому в работе заняты все потоки пула, в том числе на последнем, самом большом слиянии.
+// Данные перекладываются между диапазоном и буфером того же размера без лишних копирований
+
+namespace MT {
+
+    namespace detail {
+
+        // меньшие части сортируются и сливаются последовательно
+        inline constexpr size_t sort_leaf_min = 4096;
+        inline constexpr size_t merge_leaf_min = 8192;
+
+
+        // устойчивое слияние [first1, last1) и [first2, last2) в out с перемещением элементов
+        template <typename Iterator, typename Output, typename Compare>
+        void parallel_merge(MT::ThreadPool& pool, Iterator first1, Iterator last1, Iterator first2, Iterator last2,
+                            Output out, const Compare& comp) {
+            auto size1 = last1 - first1;
+            auto size2 = last2 - first2;
+            if (static_cast<size_t>(size1 + size2) <= merge_leaf_min) {
+                std::merge(std::make_move_iterator(first1), std::make_move_iterator(last1),
+                           std::make_move_iterator(first2), std::make_move_iterator(last2), out, comp);
+                return;
+            }
+
+            // при равенстве элементы первой последовательности идут раньше элементов второй
+            Iterator middle1;
+            Iterator middle2;
+            if (size1 >= size2) {
+                middle1 = first1 + size1 / 2;
+                middle2 = std::lower_bound(first2, last2, *middle1, comp);
+            } else {
+                middle2 = first2 + size2 / 2;
+                middle1 = std::upper_bound(first1, last1, *middle2, comp);
+            }
+            Output middle_out = out + ((middle1 - first1) + (middle2 - first2));
+            MT::parallel_invoke(pool,
+                [&]() { parallel_merge(pool, first1, middle1, first2, middle2, out, comp); },
+                [&]() { parallel_merge(pool, middle1, last1, middle2, last2, middle_out, comp); });
+        }
+
+
+        // сортирует [first, first + size); результат остаётся на месте при in_place,
+        // иначе переносится в [buffer, buffer + size)
+        template <typename Iterator, typename Buffer, typename Compare>
+        void parallel_merge_sort(MT::ThreadPool& pool, Iterator first, Buffer buffer, size_t size, size_t leaf,
+                                 bool in_place, const Compare& comp) {
+            if (size <= leaf) {
+                std::sort(first, first + size, comp);
+                if (!in_place) {
+                    std::move(first, first + size, buffer);
+                }
+                return;
+            }
+
+            // половины сортируются туда, откуда их будет сливать этот уровень
+            size_t half = size / 2;
+            MT::parallel_invoke(pool,
+                [&]() { parallel_merge_sort(pool, first, buffer, half, leaf, !in_place, comp); },
+                [&]() { parallel_merge_sort(pool, first + half, buffer + half, size - half, leaf, !in_place, comp); });
+
+            if (in_place) {
+                parallel_merge(pool, buffer, buffer + half, buffer + half, buffer + size, first, comp);
+            } else {
+                parallel_merge(pool, first, first + half, first + half, first + size, buffer, comp);
+            }
+        }
+    }
+
+
+    // Сортировка [first, last) на потоках пула; как и std::sort, неустойчивая (листья сортируются
+    // std::sort). Элементы должны конструироваться по умолчанию - под буфер выделяется
+    // std::vector того же размера. Ограничения на вызов - как у алгоритмов parallel.h
+    template <std::random_access_iterator Iterator, typename Compare = std::less<>>
+    void parallel_sort(MT::ThreadPool& pool, Iterator first, Iterator last, Compare comp = Compare()) {
+        size_t size = static_cast<size_t>(last - first);
+        size_t threads = pool.count_of_threads();
+        if (threads <= 1 || size <= 2 * detail::sort_leaf_min) {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        size_t leaf = std::max(detail::sort_leaf_min, size / (threads * detail::auto_chunks_per_thread));
+        std::vector<std::iter_value_t<Iterator>> buffer(size);
+        detail::parallel_merge_sort(pool, first, buffer.begin(), size, leaf, true, comp);
+    }
+
+
+    template <std::ranges::random_access_range Range, typename Compare = std::less<>>
+        requires std::ranges::common_range<Range>
+    void parallel_sort(MT::ThreadPool& pool, Range&& range, Compare comp = Compare()) {
+        MT::parallel_sort(pool, std::ranges::begin(range), std::ranges::end(range), std::move(comp));
+    }
+}
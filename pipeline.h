@@ -0,0 +1,277 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "thread_pool.h"
+#include "task_group.h"
+
+
+// Потоковый конвейер на пуле: источник (последовательный) порождает токены, которые проходят
+// цепочку стадий. Последовательная стадия обрабатывает токены по одному и строго в порядке
+// их порождения, параллельная - сколько угодно одновременно. Одновременно в конвейере не больше
+// max_tokens токенов: когда лимит исчерпан, источник не вызывается, пока какой-нибудь токен
+// не пройдёт все стадии, поэтому память конвейера - O(max_tokens * размер токена), а не O(входа).
+//
+// Токен, пришедший к последовательной стадии не в свою очередь, не блокирует поток: он
+// откладывается, и его продолжит задача, которая обработает предыдущий токен. Источник тоже
+// не ждёт свободного места: его перезапускает задача, завершившая токен.
+// Ограничения на вызов run - как у алгоритмов parallel.h
+
+namespace MT {
+
+    enum class StageMode {
+        // по одному токену, в порядке порождения
+        serial,
+        parallel
+    };
+
+
+    template <typename F>
+    struct PipelineStage {
+        MT::StageMode mode;
+        F function;
+    };
+
+    template <typename F>
+    MT::PipelineStage<std::decay_t<F>> serial_stage(F&& function) {
+        return {MT::StageMode::serial, std::forward<F>(function)};
+    }
+
+    template <typename F>
+    MT::PipelineStage<std::decay_t<F>> parallel_stage(F&& function) {
+        return {MT::StageMode::parallel, std::forward<F>(function)};
+    }
+
+
+    namespace detail {
+
+        // типы значений токена перед каждой стадией: In, результат первой стадии, ...
+        // (результат последней стадии не хранится)
+        template <typename In, typename... Functions>
+        struct StageTypes {
+            using type = std::tuple<In>;
+        };
+
+        template <typename In, typename F, typename Next, typename... Rest>
+        struct StageTypes<In, F, Next, Rest...> {
+            using Out = std::invoke_result_t<F&, In&&>;
+            using type = decltype(std::tuple_cat(std::declval<std::tuple<In>>(),
+                                                 std::declval<typename StageTypes<Out, Next, Rest...>::type>()));
+        };
+
+        template <typename Tuple>
+        struct TokenVariant;
+
+        template <typename... Types>
+        struct TokenVariant<std::tuple<Types...>> {
+            using type = std::variant<std::monostate, Types...>;
+        };
+
+
+        // Один запуск конвейера; стадия 0 - источник, 1..stage_count - стадии
+        template <typename Source, typename... Functions>
+        class PipelineRun {
+            using First = typename std::invoke_result_t<Source&>::value_type;
+            // значение перед стадией I лежит в варианте под индексом I
+            using Value = typename detail::TokenVariant<typename detail::StageTypes<First, Functions...>::type>::type;
+
+            static constexpr size_t stage_count = sizeof...(Functions);
+
+            struct Token {
+                uint64_t sequence;
+                Value value;
+            };
+
+            // очередь последовательной стадии: номер токена, чья очередь, и отложенные токены.
+            // Все токены от next до самого нового ещё в конвейере, их не больше max_tokens,
+            // поэтому номер % max_tokens отложенные токены не путает
+            struct SerialState {
+                uint64_t next = 0;
+                std::vector<Token*> parked;
+            };
+
+            size_t max_tokens;
+            Source& source;
+            std::tuple<MT::PipelineStage<Functions>&...> stages;
+
+            MT::TaskGroup group;
+            std::mutex mutex;
+            std::vector<SerialState> serial;
+            size_t in_flight = 0;
+            // источник выполняется одной задачей за раз
+            bool input_active = false;
+            bool input_done = false;
+            uint64_t next_sequence = 0;
+
+            // после первой ошибки функции стадий не вызываются, токены только проходят очереди
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+
+
+            void fail(std::exception_ptr stage_error) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failed.load()) {
+                    error = stage_error;
+                    failed.store(true);
+                }
+            }
+
+
+            template <size_t I>
+            void execute(Token& token) {
+                if (failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                try {
+                    auto& function = std::get<I - 1>(stages).function;
+                    auto input = std::move(std::get<I>(token.value));
+                    if constexpr (I == stage_count) {
+                        std::invoke(function, std::move(input));
+                        token.value.template emplace<0>();
+                    } else {
+                        token.value.template emplace<I + 1>(std::invoke(function, std::move(input)));
+                    }
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+            }
+
+
+            // проводит токен через стадии начиная с I
+            template <size_t I>
+            void run_from(Token* token) {
+                if constexpr (I > stage_count) {
+                    finish(token);
+                } else {
+                    if (std::get<I - 1>(stages).mode == MT::StageMode::parallel) {
+                        execute<I>(*token);
+                    } else {
+                        SerialState& state = serial[I];
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            if (state.next != token->sequence) {
+                                state.parked[token->sequence % max_tokens] = token;
+                                return;
+                            }
+                        }
+                        execute<I>(*token);
+                        // очередь переходит к следующему токену; если он уже ждёт, его продолжит отдельная задача
+                        Token* waiting = nullptr;
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            ++state.next;
+                            Token*& slot = state.parked[state.next % max_tokens];
+                            if (slot != nullptr && slot->sequence == state.next) {
+                                waiting = std::exchange(slot, nullptr);
+                            }
+                        }
+                        if (waiting != nullptr) {
+                            group.run([this, waiting]() { run_from<I>(waiting); });
+                        }
+                    }
+                    run_from<I + 1>(token);
+                }
+            }
+
+
+            void finish(Token* token) {
+                delete token;
+                bool restart_input = false;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    --in_flight;
+                    if (!input_active && !input_done && !failed.load()) {
+                        input_active = true;
+                        restart_input = true;
+                    }
+                }
+                if (restart_input) {
+                    group.run([this]() { pump(); });
+                }
+            }
+
+
+            // порождает токены, пока есть место
+            void pump() {
+                while (true) {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (failed.load() || in_flight >= max_tokens) {
+                            input_active = false;
+                            return;
+                        }
+                        ++in_flight;
+                    }
+                    std::optional<First> value;
+                    try {
+                        value = std::invoke(source);
+                    } catch (...) {
+                        fail(std::current_exception());
+                    }
+                    if (!value) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        --in_flight;
+                        input_done = true;
+                        input_active = false;
+                        return;
+                    }
+                    Token* token = new Token{next_sequence++, Value(std::in_place_index<1>, std::move(*value))};
+                    group.run([this, token]() { run_from<1>(token); });
+                }
+            }
+
+         public:
+            PipelineRun(MT::ThreadPool& pool_, size_t max_tokens_, Source& source_, MT::PipelineStage<Functions>&... stages_) :
+                    max_tokens(std::max<size_t>(1, max_tokens_)), source(source_), stages(stages_...),
+                    group(pool_), serial(stage_count + 1) {
+                for (SerialState& state : serial) {
+                    state.parked.assign(max_tokens, nullptr);
+                }
+            }
+
+            void run() {
+                input_active = true;
+                pump();
+                group.wait();
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+
+
+    // Конвейер с ограничением числа токенов в обработке
+    class Pipeline {
+        MT::ThreadPool& pool;
+        size_t max_tokens;
+
+     public:
+        // max_tokens == 0 - по четыре токена на поток пула
+        explicit Pipeline(MT::ThreadPool& pool_, size_t max_tokens_ = 0) :
+            pool(pool_), max_tokens(max_tokens_ != 0 ? max_tokens_ : 4 * std::max<size_t>(1, pool_.count_of_threads())) {}
+
+        size_t tokens() const {
+            return max_tokens;
+        }
+
+        // source() -> std::optional<T>: очередной токен или std::nullopt - вход исчерпан.
+        // Каждая стадия получает результат предыдущей (rvalue), результат последней отбрасывается.
+        // Исключение источника или стадии останавливает ввод; после завершения токенов в
+        // обработке run пробрасывает первое из исключений
+        template <typename Source, typename... Functions>
+        void run(Source&& source, MT::PipelineStage<Functions>... stages) {
+            detail::PipelineRun<std::remove_reference_t<Source>, Functions...> pipeline_run(pool, max_tokens, source, stages...);
+            pipeline_run.run();
+        }
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+
+namespace MT {
+
+    // Счётчики одной ячейки потока пула. Пишет только поток ячейки - обычными чтением и записью
+    // вместо атомарных read-modify-write; выравнивание по кэш-линии не даёт счётчикам соседних
+    // потоков делить одну линию, так что учёт не добавляет обмена между ядрами
+    struct alignas(64) WorkerCounters {
+        // выполненные задачи, в том числе завершившиеся ошибкой
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> failed{0};
+        // задачи, украденные из деков других потоков
+        std::atomic<uint64_t> steals{0};
+        // время выполнения задач (при PoolOptions::latency_metrics)
+        std::atomic<uint64_t> busy_ns{0};
+        // захваты мьютексов очередей, которым пришлось ждать другой поток
+        std::atomic<uint64_t> lock_contentions{0};
+
+        static void add(std::atomic<uint64_t>& counter, uint64_t value = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    };
+
+
+    // Состояние одной ячейки потока
+    struct WorkerStats {
+        size_t index = 0;
+        // в ячейке сейчас работает поток
+        bool alive = false;
+        // поток выполняет задачу
+        bool working = false;
+        // процессор, к которому привязан поток (-1 - без привязки), и его узел NUMA
+        int cpu = -1;
+        size_t node = 0;
+
+        uint64_t executed = 0;
+        uint64_t failed = 0;
+        uint64_t steals = 0;
+        uint64_t lock_contentions = 0;
+        std::chrono::nanoseconds busy_time{0};
+    };
+
+
+    // Результат ThreadPool::stats. Счётчики читаются без остановки пула, но в таком порядке,
+    // что completed + failed никогда не превышает submitted
+    struct PoolStats {
+        // задачи, получившие id (включая отклонённые при заполненном кольцевом буфере)
+        uint64_t submitted = 0;
+        uint64_t completed = 0;
+        // завершившиеся исключением или отклонённые
+        uint64_t failed = 0;
+
+        // задачи, ожидающие во всех очередях пула
+        size_t queue_depth = 0;
+
+        size_t threads = 0;
+        size_t working_threads = 0;
+        size_t sleeping_threads = 0;
+
+        // суммы по потокам; lock_contentions учитывает и потоки вне пула, добавляющие задачи
+        uint64_t steals = 0;
+        uint64_t lock_contentions = 0;
+
+        // запуски и завершения потоков эластичного пула (запуски включают потоки конструктора)
+        uint64_t threads_started = 0;
+        uint64_t threads_retired = 0;
+
+        // ячейки, в которых хотя бы раз работал поток
+        std::vector<MT::WorkerStats> workers;
+    };
+}
@@ -0,0 +1,275 @@
+#include "prometheus_exporter.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define MT_HAS_UNIX_SOCKETS 1
+#endif
+
+
+namespace {
+	void write_header(std::ostringstream& out, const std::string& name, const char* help, const char* type) {
+		out << "# HELP " << name << ' ' << help << '\n';
+		out << "# TYPE " << name << ' ' << type << '\n';
+	}
+
+
+	void write_metric(std::ostringstream& out, const std::string& name, const char* help, const char* type, uint64_t value) {
+		write_header(out, name, help, type);
+		out << name << ' ' << value << '\n';
+	}
+
+
+	// метрика ячеек потоков: все значения одного имени должны идти подряд
+	template <typename Value>
+	void write_worker_metric(std::ostringstream& out, const MT::PoolStats& stats, const std::string& name,
+							 const char* help, const char* type, Value value) {
+		write_header(out, name, help, type);
+		for (const MT::WorkerStats& worker : stats.workers) {
+			out << name << "{worker=\"" << worker.index << "\",node=\"" << worker.node << "\"} " << value(worker) << '\n';
+		}
+	}
+
+
+	[[noreturn]] void throw_errno(const char* what) {
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+
+	// пауза после ошибки accept, не связанной с клиентом (EMFILE, ENFILE, ENOBUFS):
+	// удваивается при каждой следующей ошибке подряд
+	constexpr int min_accept_backoff_ms = 10;
+	constexpr int max_accept_backoff_ms = 1000;
+}
+
+
+std::string MT::to_prometheus(const MT::PoolStats& stats, const std::string& prefix) {
+	std::ostringstream out;
+	write_metric(out, prefix + "_tasks_submitted_total", "Tasks submitted to the pool.", "counter", stats.submitted);
+	write_metric(out, prefix + "_tasks_completed_total", "Tasks completed successfully.", "counter", stats.completed);
+	write_metric(out, prefix + "_tasks_failed_total", "Tasks that threw or were rejected.", "counter", stats.failed);
+	write_metric(out, prefix + "_queue_depth", "Tasks waiting in the pool queues.", "gauge", stats.queue_depth);
+	write_metric(out, prefix + "_threads", "Live pool threads.", "gauge", stats.threads);
+	write_metric(out, prefix + "_working_threads", "Pool threads executing a task.", "gauge", stats.working_threads);
+	write_metric(out, prefix + "_sleeping_threads", "Pool threads waiting for tasks.", "gauge", stats.sleeping_threads);
+	write_metric(out, prefix + "_threads_started_total", "Pool threads started.", "counter", stats.threads_started);
+	write_metric(out, prefix + "_threads_retired_total", "Idle pool threads retired.", "counter", stats.threads_retired);
+	write_metric(out, prefix + "_steals_total", "Tasks stolen from other threads' deques.", "counter", stats.steals);
+	write_metric(out, prefix + "_lock_contentions_total", "Queue mutex acquisitions that had to wait.", "counter",
+				 stats.lock_contentions);
+
+	write_worker_metric(out, stats, prefix + "_worker_up", "Whether a thread runs in the slot.", "gauge",
+						[](const MT::WorkerStats& worker) { return worker.alive ? 1 : 0; });
+	write_worker_metric(out, stats, prefix + "_worker_tasks_executed_total", "Tasks executed by the slot.", "counter",
+						[](const MT::WorkerStats& worker) { return worker.executed; });
+	write_worker_metric(out, stats, prefix + "_worker_tasks_failed_total", "Failed tasks executed by the slot.", "counter",
+						[](const MT::WorkerStats& worker) { return worker.failed; });
+	write_worker_metric(out, stats, prefix + "_worker_steals_total", "Tasks stolen by the slot.", "counter",
+						[](const MT::WorkerStats& worker) { return worker.steals; });
+	write_worker_metric(out, stats, prefix + "_worker_lock_contentions_total", "Contended queue locks of the slot.", "counter",
+						[](const MT::WorkerStats& worker) { return worker.lock_contentions; });
+	out << std::fixed << std::setprecision(9);
+	write_worker_metric(out, stats, prefix + "_worker_busy_seconds_total", "Time the slot spent executing tasks.", "counter",
+						[](const MT::WorkerStats& worker) { return std::chrono::duration<double>(worker.busy_time).count(); });
+	return out.str();
+}
+
+
+MT::PrometheusExporter::PrometheusExporter(MT::ThreadPool& pool_ref, const MT::ExporterOptions& options_) :
+		pool(pool_ref), options(options_), stopped(false), listen_fd(-1), wake_pipe{-1, -1}, failed(0) {
+	if (options.target == MT::ExportTarget::file) {
+		exporter_thread = std::thread(&PrometheusExporter::write_file_periodically, this);
+		return;
+	}
+
+#ifdef MT_HAS_UNIX_SOCKETS
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (options.path.empty() || options.path.size() >= sizeof(address.sun_path)) {
+		throw std::invalid_argument("Unix socket path is empty or too long: " + options.path);
+	}
+	options.path.copy(address.sun_path, options.path.size());
+
+	try {
+		if (pipe(wake_pipe) != 0) {
+			throw_errno("pipe");
+		}
+		listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listen_fd < 0) {
+			throw_errno("socket");
+		}
+		// сокет, оставшийся от прошлого запуска, мешает bind; другие файлы не трогаем
+		std::error_code error;
+		if (std::filesystem::is_socket(options.path, error)) {
+			unlink(options.path.c_str());
+		}
+		if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+			throw_errno("bind");
+		}
+		if (listen(listen_fd, 16) != 0) {
+			throw_errno("listen");
+		}
+		exporter_thread = std::thread(&PrometheusExporter::serve_socket, this);
+	} catch (...) {
+		// деструктор не будет вызван
+		close_descriptors();
+		throw;
+	}
+#else
+	throw std::runtime_error("Unix sockets are not supported on this platform");
+#endif
+}
+
+
+MT::PrometheusExporter::~PrometheusExporter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	wakeup.notify_one();
+#ifdef MT_HAS_UNIX_SOCKETS
+	if (wake_pipe[1] >= 0) {
+		char byte = 0;
+		while (write(wake_pipe[1], &byte, 1) < 0 && errno == EINTR) {}
+	}
+#endif
+	if (exporter_thread.joinable()) {
+		exporter_thread.join();
+	}
+	close_descriptors();
+}
+
+
+void MT::PrometheusExporter::close_descriptors() {
+#ifdef MT_HAS_UNIX_SOCKETS
+	if (listen_fd >= 0) {
+		close(listen_fd);
+		unlink(options.path.c_str());
+		listen_fd = -1;
+	}
+	for (int& fd : wake_pipe) {
+		if (fd >= 0) {
+			close(fd);
+			fd = -1;
+		}
+	}
+#endif
+}
+
+
+bool MT::PrometheusExporter::export_now() {
+	std::string text = MT::to_prometheus(pool.stats(), options.prefix);
+	std::string temporary_path = options.path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::trunc);
+		file << text;
+		file.close();
+		if (!file) {
+			failed.fetch_add(1);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary_path, options.path, error);
+	if (error) {
+		failed.fetch_add(1);
+		return false;
+	}
+	return true;
+}
+
+
+size_t MT::PrometheusExporter::failed_exports() const {
+	return failed.load();
+}
+
+
+void MT::PrometheusExporter::write_file_periodically() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!stopped) {
+		lock.unlock();
+		// неудача учтена в failed_exports, следующая попытка - через interval
+		export_now();
+		lock.lock();
+		wakeup.wait_for(lock, options.interval, [this]() -> bool { return stopped; });
+	}
+}
+
+
+void MT::PrometheusExporter::serve_socket() {
+#ifdef MT_HAS_UNIX_SOCKETS
+	int backoff_ms = 0;
+	while (true) {
+		pollfd fds[2] = {{listen_fd, POLLIN, 0}, {wake_pipe[0], POLLIN, 0}};
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			failed.fetch_add(1);
+			return;
+		}
+		if (fds[1].revents != 0) {
+			return;
+		}
+		if ((fds[0].revents & POLLIN) == 0) {
+			continue;
+		}
+
+		int client = accept(listen_fd, nullptr, nullptr);
+		if (client < 0) {
+			if (errno == EINTR || errno == ECONNABORTED || errno == EAGAIN || errno == EWOULDBLOCK) {
+				continue;
+			}
+			// ожидающее соединение остаётся в очереди, и poll сразу вернёт его снова:
+			// без паузы поток крутился бы, пока не освободятся дескрипторы
+			failed.fetch_add(1);
+			backoff_ms = backoff_ms == 0 ? min_accept_backoff_ms : std::min(2 * backoff_ms, max_accept_backoff_ms);
+			pollfd wake = {wake_pipe[0], POLLIN, 0};
+			if (poll(&wake, 1, backoff_ms) > 0) {
+				return;
+			}
+			continue;
+		}
+		backoff_ms = 0;
+
+		// метрики обычно помещаются в буфер сокета, но клиент, не читающий ответ,
+		// задерживает экспортёр не дольше send_timeout
+		timeval timeout{};
+		timeout.tv_sec = static_cast<time_t>(options.send_timeout.count() / 1000);
+		timeout.tv_usec = static_cast<suseconds_t>(options.send_timeout.count() % 1000 * 1000);
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		std::string text = MT::to_prometheus(pool.stats(), options.prefix);
+		size_t sent = 0;
+		while (sent < text.size()) {
+#ifdef MSG_NOSIGNAL
+			ssize_t written = send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+#else
+			ssize_t written = send(client, text.data() + sent, text.size() - sent, 0);
+#endif
+			if (written < 0 && errno == EINTR) {
+				continue;
+			}
+			if (written <= 0) {
+				failed.fetch_add(1);
+				break;
+			}
+			sent += static_cast<size_t>(written);
+		}
+		close(client);
+	}
+#endif
+}
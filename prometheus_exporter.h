@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "pool_stats.h"
+
+
+namespace MT {
+
+    class ThreadPool;
+
+
+    // Куда PrometheusExporter отдаёт метрики
+    enum class ExportTarget {
+        // файл перезаписывается раз в interval (для textfile collector у node exporter);
+        // сначала пишется path + ".tmp", затем переименовывается, так что читатель не видит половины файла
+        file,
+        // экспортёр слушает Unix сокет path и отдаёт каждому подключившемуся свежие метрики
+        unix_socket
+    };
+
+
+    struct ExporterOptions {
+        MT::ExportTarget target = MT::ExportTarget::file;
+        std::string path = "thread_pool.prom";
+        // период записи файла (для ExportTarget::unix_socket не используется)
+        std::chrono::milliseconds interval{std::chrono::seconds(15)};
+        // сколько ExportTarget::unix_socket ждёт клиента, не читающего ответ, прежде чем закрыть соединение
+        std::chrono::milliseconds send_timeout{std::chrono::seconds(1)};
+        // префикс имён метрик
+        std::string prefix = "thread_pool";
+    };
+
+
+    // ThreadPool::stats в текстовом формате Prometheus
+    std::string to_prometheus(const MT::PoolStats& stats, const std::string& prefix = "thread_pool");
+
+
+    // Фоновый поток, публикующий ThreadPool::stats в текстовом формате Prometheus.
+    // Должен быть уничтожен раньше пула
+    class PrometheusExporter {
+        MT::ThreadPool& pool;
+        const MT::ExporterOptions options;
+
+        std::thread exporter_thread;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        bool stopped;
+
+        // сокет ExportTarget::unix_socket и канал, которым деструктор будит ожидающий его poll
+        int listen_fd;
+        int wake_pipe[2];
+
+        // неудачные записи файла или ответы клиентам сокета
+        std::atomic<size_t> failed;
+
+        void write_file_periodically();
+
+        void serve_socket();
+
+        void close_descriptors();
+
+     public:
+        // для ExportTarget::unix_socket бросает std::system_error, если сокет не удалось открыть
+        PrometheusExporter(MT::ThreadPool& pool_ref, const MT::ExporterOptions& options_ = MT::ExporterOptions());
+
+        PrometheusExporter(const PrometheusExporter& other) = delete;
+        PrometheusExporter& operator=(const PrometheusExporter& other) = delete;
+
+        // записывает файл немедленно, false - запись не удалась (для ExportTarget::file)
+        bool export_now();
+
+        size_t failed_exports() const;
+
+        ~PrometheusExporter();
+    };
+}
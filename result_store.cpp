@@ -0,0 +1,171 @@
+#include "result_store.h"
+#include <ranges>
+#include "thread_pool.h"
+
+
+MT::ResultStore::ResultStore(const MT::ResultRetention& retention_) :
+		retention(retention_), total_entries(0), total_bytes(0), sweep_cursor(0),
+		evicted_by_count(0), evicted_by_bytes(0), expired(0), consumed(0) {}
+
+
+void MT::ResultStore::erase(Shard& shard, std::unordered_map<size_t, Entry>::iterator it, Garbage& garbage) {
+	shard.bytes -= it->second.bytes;
+	total_entries.fetch_sub(1);
+	total_bytes.fetch_sub(it->second.bytes);
+	garbage.push_back(std::move(it->second.task));
+	shard.entries.erase(it);
+}
+
+
+void MT::ResultStore::evict(Shard& shard, size_t keep, std::chrono::steady_clock::time_point now, Garbage& garbage) {
+	while (!shard.order.empty()) {
+		auto it = shard.entries.find(shard.order.front());
+		if (it == shard.entries.end()) {
+			// результат уже прочитан с consume_on_read или просрочен при чтении
+			shard.order.pop_front();
+			continue;
+		}
+
+		if (retention.ttl.count() != 0 && it->second.expires <= now) {
+			expired.fetch_add(1, std::memory_order_relaxed);
+		} else if (it->first == keep) {
+			break;
+		} else if (retention.max_entries != 0 && total_entries.load() > retention.max_entries) {
+			evicted_by_count.fetch_add(1, std::memory_order_relaxed);
+		} else if (retention.max_bytes != 0 && total_bytes.load() > retention.max_bytes) {
+			evicted_by_bytes.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			break;
+		}
+		erase(shard, it, garbage);
+		shard.order.pop_front();
+	}
+
+	// id, удалённые при чтении из середины очереди, не должны копиться бесконечно
+	if (shard.order.size() > 2 * shard.entries.size() + 64) {
+		std::erase_if(shard.order, [&shard](size_t task_id) { return !shard.entries.contains(task_id); });
+	}
+}
+
+
+void MT::ResultStore::sweep(std::chrono::steady_clock::time_point now, Garbage& garbage) {
+	if (retention.ttl.count() == 0) {
+		return;
+	}
+	Shard& shard = shards[sweep_cursor.fetch_add(1, std::memory_order_relaxed) % shards_count];
+	std::unique_lock<std::mutex> lock(shard.mutex, std::try_to_lock);
+	if (lock.owns_lock()) {
+		evict(shard, no_task, now, garbage);
+	}
+}
+
+
+void MT::ResultStore::insert(size_t task_id, std::shared_ptr<MT::Task> task) {
+	// размер считается до захвата шарда
+	size_t bytes = task->memory_footprint();
+	store(task_id, std::move(task), bytes, false);
+}
+
+
+void MT::ResultStore::insert_failure(size_t task_id) {
+	store(task_id, nullptr, sizeof(Entry), true);
+}
+
+
+void MT::ResultStore::store(size_t task_id, std::shared_ptr<MT::Task> task, size_t bytes, bool failed) {
+	auto now = std::chrono::steady_clock::now();
+	auto expires = retention.ttl.count() != 0 ? now + retention.ttl : std::chrono::steady_clock::time_point::max();
+
+	Garbage garbage;
+	size_t home = task_id % shards_count;
+	{
+		Shard& shard = shards[home];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto [it, inserted] = shard.entries.try_emplace(task_id, Entry{task, bytes, expires, failed});
+		if (!inserted) {
+			shard.bytes -= it->second.bytes;
+			total_bytes.fetch_sub(it->second.bytes);
+			garbage.push_back(std::exchange(it->second.task, std::move(task)));
+			it->second.bytes = bytes;
+			it->second.expires = expires;
+			it->second.failed = failed;
+		} else {
+			shard.order.push_back(task_id);
+			total_entries.fetch_add(1);
+		}
+		shard.bytes += bytes;
+		total_bytes.fetch_add(bytes);
+		evict(shard, task_id, now, garbage);
+	}
+
+	// более старых результатов в своём шарде не осталось - вытесняются результаты соседних,
+	// шарды блокируются по одному; новый результат вытесняется последним
+	for (size_t step : std::ranges::iota_view(size_t(1), shards_count + 1)) {
+		if (!over_limit()) {
+			break;
+		}
+		Shard& shard = shards[(home + step) % shards_count];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		evict(shard, no_task, now, garbage);
+	}
+
+	sweep(now, garbage);
+}
+
+
+MT::ResultStore::Lookup MT::ResultStore::lookup(size_t task_id) {
+	Garbage garbage;
+	sweep(std::chrono::steady_clock::now(), garbage);
+
+	Shard& shard = shard_for(task_id);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	auto it = shard.entries.find(task_id);
+	if (it == shard.entries.end()) {
+		return {};
+	}
+
+	if (retention.ttl.count() != 0 && it->second.expires <= std::chrono::steady_clock::now()) {
+		expired.fetch_add(1, std::memory_order_relaxed);
+		erase(shard, it, garbage);
+		return {};
+	}
+
+	Lookup result{it->second.task, it->second.failed};
+	if (retention.consume_on_read) {
+		consumed.fetch_add(1, std::memory_order_relaxed);
+		erase(shard, it, garbage);
+	}
+	return result;
+}
+
+
+void MT::ResultStore::clear() {
+	for (Shard& shard : shards) {
+		std::unordered_map<size_t, Entry> entries;
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		total_entries.fetch_sub(shard.entries.size());
+		total_bytes.fetch_sub(shard.bytes);
+		entries.swap(shard.entries);
+		shard.order.clear();
+		shard.bytes = 0;
+	}
+}
+
+
+MT::ResultStoreStats MT::ResultStore::stats() {
+	MT::ResultStoreStats result;
+	Garbage garbage;
+	auto now = std::chrono::steady_clock::now();
+	for (Shard& shard : shards) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		// все шарды всё равно блокируются - заодно из них удаляются просроченные результаты
+		evict(shard, no_task, now, garbage);
+		result.entries += shard.entries.size();
+		result.bytes += shard.bytes;
+	}
+	result.evicted_by_count = evicted_by_count.load();
+	result.evicted_by_bytes = evicted_by_bytes.load();
+	result.expired = expired.load();
+	result.consumed = consumed.load();
+	return result;
+}
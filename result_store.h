@@ -0,0 +1,149 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace MT {
+
+    class Task;
+
+    // Ограничения хранилища результатов, 0 - без ограничения
+    struct ResultRetention {
+        // максимальное число хранимых результатов
+        size_t max_entries = 0;
+
+        // максимальный суммарный Task::memory_footprint() хранимых задач
+        size_t max_bytes = 0;
+
+        // время жизни результата после завершения задачи
+        std::chrono::milliseconds ttl{0};
+
+        // результат удаляется при первом успешном чтении
+        bool consume_on_read = false;
+    };
+
+
+    struct ResultStoreStats {
+        size_t entries = 0;
+        size_t bytes = 0;
+
+        // вытеснено самых старых результатов из-за max_entries и max_bytes
+        size_t evicted_by_count = 0;
+        size_t evicted_by_bytes = 0;
+        // удалено по истечении ttl
+        size_t expired = 0;
+        // удалено при чтении (consume_on_read)
+        size_t consumed = 0;
+    };
+
+
+    // Хранилище результатов выполненных задач, разбитое на шарды по id задачи,
+    // чтобы потоки, завершающие разные задачи, не толкались на одном мьютексе.
+    // Ограничения max_entries и max_bytes общие для всех шардов: при превышении первыми вытесняются
+    // самые старые результаты шарда, в который добавляется результат, затем соседних шардов.
+    // Просроченные результаты удаляются и в шардах, к которым никто не обращается: каждое
+    // обращение к хранилищу просматривает ещё один шард по кругу
+    class ResultStore {
+        static constexpr size_t shards_count = 16;
+        // вытеснять можно любой результат
+        static constexpr size_t no_task = std::numeric_limits<size_t>::max();
+
+        struct Entry {
+            // nullptr у записи о задаче, завершившейся ошибкой
+            std::shared_ptr<MT::Task> task;
+            size_t bytes;
+            std::chrono::steady_clock::time_point expires;
+            bool failed;
+        };
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<size_t, Entry> entries;
+            // id в порядке добавления; id уже удалённых результатов пропускаются при вытеснении
+            std::deque<size_t> order;
+            size_t bytes = 0;
+        };
+
+        const MT::ResultRetention retention;
+
+        std::array<Shard, shards_count> shards;
+
+        // сумма по всем шардам, меняется под мьютексом шарда
+        std::atomic<size_t> total_entries;
+        std::atomic<size_t> total_bytes;
+        // следующий шард для удаления просроченных результатов
+        std::atomic<size_t> sweep_cursor;
+
+        std::atomic<size_t> evicted_by_count;
+        std::atomic<size_t> evicted_by_bytes;
+        std::atomic<size_t> expired;
+        std::atomic<size_t> consumed;
+
+        Shard& shard_for(size_t task_id) {
+            return shards[task_id % shards_count];
+        }
+
+        // удалённые задачи разрушаются только после снятия блокировки шарда:
+        // деструктор задачи может ждать другие задачи, которые как раз кладут сюда результат
+        using Garbage = std::vector<std::shared_ptr<MT::Task>>;
+
+        bool over_limit() const {
+            return (retention.max_entries != 0 && total_entries.load() > retention.max_entries) ||
+                   (retention.max_bytes != 0 && total_bytes.load() > retention.max_bytes);
+        }
+
+        // удаляет результат, shard.mutex должен быть захвачен
+        void erase(Shard& shard, std::unordered_map<size_t, Entry>::iterator it, Garbage& garbage);
+
+        // удаляет с начала очереди шарда просроченные результаты и, пока превышены общие ограничения,
+        // самые старые, но не keep; shard.mutex должен быть захвачен
+        void evict(Shard& shard, size_t keep, std::chrono::steady_clock::time_point now, Garbage& garbage);
+
+        // удаляет просроченные результаты очередного шарда; занятый шард пропускается
+        void sweep(std::chrono::steady_clock::time_point now, Garbage& garbage);
+
+        void store(size_t task_id, std::shared_ptr<MT::Task> task, size_t bytes, bool failed);
+
+     public:
+        explicit ResultStore(const MT::ResultRetention& retention_ = MT::ResultRetention());
+
+        ResultStore(const ResultStore& other) = delete;
+        ResultStore& operator=(const ResultStore& other) = delete;
+
+        struct Lookup {
+            std::shared_ptr<MT::Task> task;
+            // задача завершилась ошибкой (task == nullptr)
+            bool failed = false;
+        };
+
+        void insert(size_t task_id, std::shared_ptr<MT::Task> task);
+
+        // запоминает, что задача завершилась ошибкой; запись подчиняется тем же ограничениям, что и результаты
+        void insert_failure(size_t task_id);
+
+        // результат или отметка об ошибке; пусто, если записи нет, она просрочена или уже вытеснена
+        Lookup lookup(size_t task_id);
+
+        // nullptr, если результата нет, он просрочен, вытеснен или задача завершилась ошибкой
+        std::shared_ptr<MT::Task> find(size_t task_id) {
+            return lookup(task_id).task;
+        }
+
+        void clear();
+
+        // true, если результаты могут удаляться без clear()
+        bool is_bounded() const {
+            return retention.max_entries != 0 || retention.max_bytes != 0 ||
+                   retention.ttl.count() != 0 || retention.consume_on_read;
+        }
+
+        MT::ResultStoreStats stats();
+    };
+}
@@ -0,0 +1,225 @@
+#include "run_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MT_HAS_MMAP 1
+#endif
+
+
+MT::MappedFile::MappedFile(const std::filesystem::path& path, bool sequential) {
+#ifdef MT_HAS_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::system_error(errno, std::generic_category(), "Couldn't open " + path.string());
+	}
+	struct stat info;
+	if (::fstat(fd, &info) != 0) {
+		int error = errno;
+		::close(fd);
+		throw std::system_error(error, std::generic_category(), "Couldn't stat " + path.string());
+	}
+	length = static_cast<size_t>(info.st_size);
+	if (length != 0) {
+		void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			int error = errno;
+			::close(fd);
+			throw std::system_error(error, std::generic_category(), "Couldn't map " + path.string());
+		}
+		if (sequential) {
+			// только подсказка ядру, ошибка не мешает чтению
+			::madvise(mapping, length, MADV_SEQUENTIAL);
+		}
+		bytes = static_cast<const std::byte*>(mapping);
+	}
+	// отображение остаётся действительным и после закрытия дескриптора
+	::close(fd);
+#else
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory), "Couldn't open " + path.string());
+	}
+	fallback.resize(std::filesystem::file_size(path));
+	file.read(reinterpret_cast<char*>(fallback.data()), fallback.size());
+	bytes = fallback.data();
+	length = fallback.size();
+#endif
+}
+
+
+MT::MappedFile::MappedFile(MT::MappedFile&& other) noexcept :
+		bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)),
+		fallback(std::move(other.fallback)) {}
+
+
+MT::MappedFile& MT::MappedFile::operator=(MT::MappedFile&& other) noexcept {
+	if (this != &other) {
+		release();
+		bytes = std::exchange(other.bytes, nullptr);
+		length = std::exchange(other.length, 0);
+		fallback = std::move(other.fallback);
+	}
+	return *this;
+}
+
+
+MT::MappedFile::~MappedFile() {
+	release();
+}
+
+
+void MT::MappedFile::release() noexcept {
+#ifdef MT_HAS_MMAP
+	if (bytes != nullptr) {
+		::munmap(const_cast<std::byte*>(bytes), length);
+	}
+#endif
+	bytes = nullptr;
+	length = 0;
+	fallback.clear();
+}
+
+
+MT::RunHeader MT::read_run_header(const MT::MappedFile& file, MT::RunElementType element_type,
+								  size_t element_size, const std::filesystem::path& path) {
+	MT::RunHeader header;
+	if (file.size() < sizeof(MT::RunHeader)) {
+		throw std::runtime_error("Run file is too short: " + path.string());
+	}
+	std::memcpy(&header, file.data(), sizeof(MT::RunHeader));
+
+	if (header.magic != MT::RunHeader::expected_magic || header.version != MT::RunHeader::current_version) {
+		throw std::runtime_error("Not a run file or unsupported version: " + path.string());
+	}
+	if (header.element_size != element_size || header.element_type != element_type) {
+		throw std::runtime_error("Run file element type mismatch: " + path.string());
+	}
+	if (header.count > (file.size() - sizeof(MT::RunHeader)) / element_size) {
+		throw std::runtime_error("Run file is truncated: " + path.string());
+	}
+	return header;
+}
+
+
+MT::BlockFileWriter::BlockFileWriter(const std::filesystem::path& path_, bool create, uint64_t offset) :
+		path(path_), buffer(buffer_size) {
+	file = std::fopen(path.string().c_str(), create ? "wb" : "r+b");
+	if (file == nullptr) {
+		throw std::system_error(errno, std::generic_category(), "Couldn't open " + path.string() + " for writing");
+	}
+	// буферизует сам писатель: stdio только передаёт готовые блоки в write
+	std::setvbuf(file, nullptr, _IONBF, 0);
+	if (offset != 0 && std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0) {
+		int error = errno;
+		std::fclose(file);
+		throw std::system_error(error, std::generic_category(), "Couldn't seek in " + path.string());
+	}
+}
+
+
+MT::BlockFileWriter::BlockFileWriter(MT::BlockFileWriter&& other) noexcept :
+		file(std::exchange(other.file, nullptr)), path(std::move(other.path)),
+		buffer(std::move(other.buffer)), buffered(std::exchange(other.buffered, 0)) {}
+
+
+MT::BlockFileWriter::~BlockFileWriter() {
+	if (file != nullptr) {
+		std::fclose(file);
+	}
+}
+
+
+void MT::BlockFileWriter::append_slow(const void* data, size_t bytes) {
+	flush();
+	if (bytes >= buffer_size) {
+		// большой блок пишется напрямую, минуя буфер
+		if (std::fwrite(data, 1, bytes, file) != bytes) {
+			throw std::system_error(errno, std::generic_category(), "Couldn't write " + path.string());
+		}
+		return;
+	}
+	std::memcpy(buffer.data(), data, bytes);
+	buffered = bytes;
+}
+
+
+void MT::BlockFileWriter::flush() {
+	if (buffered != 0 && std::fwrite(buffer.data(), 1, buffered, file) != buffered) {
+		throw std::system_error(errno, std::generic_category(), "Couldn't write " + path.string());
+	}
+	buffered = 0;
+}
+
+
+void MT::BlockFileWriter::rewrite_front(const void* data, size_t bytes) {
+	flush();
+	if (std::fseek(file, 0, SEEK_SET) != 0 || std::fwrite(data, 1, bytes, file) != bytes) {
+		throw std::system_error(errno, std::generic_category(), "Couldn't write " + path.string());
+	}
+}
+
+
+void MT::BlockFileWriter::close() {
+	flush();
+	bool closed = std::fclose(file) == 0;
+	file = nullptr;
+	if (!closed) {
+		throw std::system_error(errno, std::generic_category(), "Couldn't finish " + path.string());
+	}
+}
+
+
+MT::RunFileWriter::RunFileWriter(const std::filesystem::path& path, MT::RunElementType element_type, size_t element_size) :
+		writer(path, true) {
+	header.element_type = element_type;
+	header.element_size = static_cast<uint32_t>(element_size);
+	// настоящий заголовок пишется в close(); до тех пор magic нулевой, и серия не читается
+	MT::RunHeader placeholder = header;
+	placeholder.magic = 0;
+	writer.append(&placeholder, sizeof(placeholder));
+}
+
+
+void MT::RunFileWriter::close(uint64_t count, bool sorted) {
+	header.count = count;
+	header.flags = sorted ? MT::RunHeader::sorted_flag : 0;
+	writer.rewrite_front(&header, sizeof(header));
+	writer.close();
+}
+
+
+void MT::create_run_file(const std::filesystem::path& path, MT::RunElementType element_type,
+						 size_t element_size, uint64_t count) {
+	MT::RunHeader placeholder;
+	placeholder.magic = 0;
+	placeholder.element_type = element_type;
+	placeholder.element_size = static_cast<uint32_t>(element_size);
+	{
+		MT::BlockFileWriter writer(path, true);
+		writer.append(&placeholder, sizeof(placeholder));
+		writer.close();
+	}
+	// части пишутся в уже выделенный файл нужной длины
+	std::filesystem::resize_file(path, sizeof(MT::RunHeader) + count * element_size);
+}
+
+
+void MT::finish_run_file(const std::filesystem::path& path, MT::RunElementType element_type,
+						 size_t element_size, uint64_t count, bool sorted) {
+	MT::RunHeader header;
+	header.element_type = element_type;
+	header.element_size = static_cast<uint32_t>(element_size);
+	header.count = count;
+	header.flags = sorted ? MT::RunHeader::sorted_flag : 0;
+	MT::BlockFileWriter writer(path, false);
+	writer.append(&header, sizeof(header));
+	writer.close();
+}
@@ -0,0 +1,307 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+// Двоичный формат серий (run) для внешней сортировки: заголовок RunHeader и сразу за ним
+// count элементов в машинном представлении. Файлы читаются через mmap последовательно
+// (MADV_SEQUENTIAL), пишутся большими блоками; в текст серия переводится только по запросу (run_to_text)
+
+namespace MT {
+
+    // Тип элементов серии, записанный в заголовке
+    enum class RunElementType : uint8_t {
+        // тип без собственного кода, проверяется только размер элемента
+        raw,
+        int8, uint8, int16, uint16, int32, uint32, int64, uint64,
+        float32, float64
+    };
+
+
+    template <typename T>
+    constexpr MT::RunElementType run_element_type() {
+        if constexpr (std::is_same_v<T, int8_t>) return MT::RunElementType::int8;
+        else if constexpr (std::is_same_v<T, uint8_t>) return MT::RunElementType::uint8;
+        else if constexpr (std::is_same_v<T, int16_t>) return MT::RunElementType::int16;
+        else if constexpr (std::is_same_v<T, uint16_t>) return MT::RunElementType::uint16;
+        else if constexpr (std::is_same_v<T, int32_t>) return MT::RunElementType::int32;
+        else if constexpr (std::is_same_v<T, uint32_t>) return MT::RunElementType::uint32;
+        else if constexpr (std::is_same_v<T, int64_t>) return MT::RunElementType::int64;
+        else if constexpr (std::is_same_v<T, uint64_t>) return MT::RunElementType::uint64;
+        else if constexpr (std::is_same_v<T, float>) return MT::RunElementType::float32;
+        else if constexpr (std::is_same_v<T, double>) return MT::RunElementType::float64;
+        else return MT::RunElementType::raw;
+    }
+
+
+    // Заголовок файла серии; 32 байта, поэтому элементы до 8 байт в отображённом файле выровнены
+    struct RunHeader {
+        static constexpr uint32_t expected_magic = 0x4E52544D;  // "MTRN" в little-endian
+        static constexpr uint16_t current_version = 1;
+        // элементы серии упорядочены по возрастанию (в смысле компаратора писавшего)
+        static constexpr uint8_t sorted_flag = 1;
+
+        uint32_t magic = expected_magic;
+        uint16_t version = current_version;
+        MT::RunElementType element_type = MT::RunElementType::raw;
+        uint8_t flags = 0;
+        uint32_t element_size = 0;
+        uint32_t reserved = 0;
+        uint64_t count = 0;
+        uint64_t reserved2 = 0;
+
+        bool is_sorted() const {
+            return (flags & sorted_flag) != 0;
+        }
+    };
+
+    static_assert(sizeof(MT::RunHeader) == 32 && std::is_trivially_copyable_v<MT::RunHeader>);
+
+
+    // Файл, отображённый в память только для чтения. Где mmap недоступен, файл читается целиком
+    class MappedFile {
+        const std::byte* bytes = nullptr;
+        size_t length = 0;
+        // содержимое файла, если он прочитан без mmap
+        std::vector<std::byte> fallback;
+
+        void release() noexcept;
+
+     public:
+        MappedFile() = default;
+
+        // sequential - файл будет читаться от начала к концу (MADV_SEQUENTIAL: упреждающее чтение
+        // и ранний сброс прочитанных страниц); бросает std::system_error, если файл не открыть
+        explicit MappedFile(const std::filesystem::path& path, bool sequential = true);
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        const std::byte* data() const {
+            return bytes;
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        ~MappedFile();
+    };
+
+
+    // проверяет заголовок отображённой серии, бросает std::runtime_error при несовпадении формата
+    MT::RunHeader read_run_header(const MT::MappedFile& file, MT::RunElementType element_type,
+                                  size_t element_size, const std::filesystem::path& path);
+
+
+    // Запись в файл блоками по buffer_size байт: мелкие записи копируются в буфер,
+    // в файл уходят только целые блоки
+    class BlockFileWriter {
+        std::FILE* file = nullptr;
+        std::filesystem::path path;
+        std::vector<std::byte> buffer;
+        size_t buffered = 0;
+
+        // блок не поместился в буфер
+        void append_slow(const void* data, size_t bytes);
+
+     public:
+        static constexpr size_t buffer_size = 1 << 20;
+
+        // create - создать файл заново, иначе писать поверх существующего, начиная с offset байт
+        BlockFileWriter(const std::filesystem::path& path_, bool create, uint64_t offset = 0);
+
+        BlockFileWriter(BlockFileWriter&& other) noexcept;
+
+        BlockFileWriter(const BlockFileWriter& other) = delete;
+        BlockFileWriter& operator=(const BlockFileWriter& other) = delete;
+
+        void append(const void* data, size_t bytes) {
+            if (buffered + bytes <= buffer_size) {
+                std::memcpy(buffer.data() + buffered, data, bytes);
+                buffered += bytes;
+                return;
+            }
+            append_slow(data, bytes);
+        }
+
+        void flush();
+
+        // дописывает буфер и перезаписывает bytes байт с начала файла (заголовок)
+        void rewrite_front(const void* data, size_t bytes);
+
+        // дописывает буфер и закрывает файл, бросает std::system_error при ошибке записи
+        void close();
+
+        ~BlockFileWriter();
+    };
+
+
+    // Запись новой серии. Заголовок с числом элементов дописывается в close();
+    // файл без close() (например, при исключении) считается повреждённым
+    class RunFileWriter {
+        MT::BlockFileWriter writer;
+        MT::RunHeader header;
+
+     public:
+        RunFileWriter(const std::filesystem::path& path, MT::RunElementType element_type, size_t element_size);
+
+        void append(const void* data, size_t bytes) {
+            writer.append(data, bytes);
+        }
+
+        // записывает заголовок; sorted - писавший гарантирует упорядоченность элементов
+        void close(uint64_t count, bool sorted);
+    };
+
+
+    // Типизированный писатель серии
+    template <typename T>
+    class RunWriter {
+        static_assert(std::is_trivially_copyable_v<T>, "run files store elements as raw bytes");
+
+        MT::RunFileWriter writer;
+        uint64_t count = 0;
+
+     public:
+        explicit RunWriter(const std::filesystem::path& path) :
+            writer(path, MT::run_element_type<T>(), sizeof(T)) {}
+
+        void write(const T& value) {
+            writer.append(&value, sizeof(T));
+            ++count;
+        }
+
+        void write(std::span<const T> values) {
+            writer.append(values.data(), values.size_bytes());
+            count += values.size();
+        }
+
+        void close(bool sorted) {
+            writer.close(count, sorted);
+        }
+    };
+
+
+    // создаёт файл серии из count элементов с незаполненными элементами и нулевым magic
+    void create_run_file(const std::filesystem::path& path, MT::RunElementType element_type,
+                         size_t element_size, uint64_t count);
+
+    // записывает окончательный заголовок серии, созданной create_run_file
+    void finish_run_file(const std::filesystem::path& path, MT::RunElementType element_type,
+                         size_t element_size, uint64_t count, bool sorted);
+
+
+    // Писатель части серии: элементы с номера first подряд
+    template <typename T>
+    class RunSliceWriter {
+        MT::BlockFileWriter writer;
+
+     public:
+        RunSliceWriter(const std::filesystem::path& path, uint64_t first) :
+            writer(path, false, sizeof(MT::RunHeader) + first * sizeof(T)) {}
+
+        void write(const T& value) {
+            writer.append(&value, sizeof(T));
+        }
+
+        void write(std::span<const T> values) {
+            writer.append(values.data(), values.size_bytes());
+        }
+
+        void close() {
+            writer.close();
+        }
+    };
+
+
+    // Серия известной длины, непересекающиеся части которой пишут разные потоки
+    // (каждый через свой RunSliceWriter). Читать её можно только после close()
+    template <typename T>
+    class RunSlices {
+        static_assert(std::is_trivially_copyable_v<T>, "run files store elements as raw bytes");
+
+        std::filesystem::path path;
+        uint64_t count;
+
+     public:
+        RunSlices(const std::filesystem::path& path_, uint64_t count_) : path(path_), count(count_) {
+            MT::create_run_file(path, MT::run_element_type<T>(), sizeof(T), count);
+        }
+
+        MT::RunSliceWriter<T> slice(uint64_t first) const {
+            return MT::RunSliceWriter<T>(path, first);
+        }
+
+        // вызывается, когда все части записаны и закрыты
+        void close(bool sorted) {
+            MT::finish_run_file(path, MT::run_element_type<T>(), sizeof(T), count, sorted);
+        }
+    };
+
+
+    // Серия, отображённая в память
+    template <typename T>
+    class RunReader {
+        static_assert(std::is_trivially_copyable_v<T>, "run files store elements as raw bytes");
+
+        MT::MappedFile file;
+        MT::RunHeader header;
+
+     public:
+        explicit RunReader(const std::filesystem::path& path) :
+            file(path), header(MT::read_run_header(file, MT::run_element_type<T>(), sizeof(T), path)) {}
+
+        std::span<const T> values() const {
+            return std::span<const T>(reinterpret_cast<const T*>(file.data() + sizeof(MT::RunHeader)), header.count);
+        }
+
+        size_t size() const {
+            return header.count;
+        }
+
+        bool is_sorted() const {
+            return header.is_sorted();
+        }
+    };
+
+
+    // переводит серию в текст (элементы через пробел) - только для человека, читающего результат
+    template <typename T>
+    void run_to_text(const std::filesystem::path& run_path, const std::filesystem::path& text_path) {
+        MT::RunReader<T> run(run_path);
+        std::FILE* text = std::fopen(text_path.string().c_str(), "wb");
+        if (text == nullptr) {
+            throw std::runtime_error("Couldn't create " + text_path.string());
+        }
+        std::vector<char> buffer(MT::BlockFileWriter::buffer_size);
+        size_t used = 0;
+        bool ok = true;
+        for (const T& value : run.values()) {
+            if (buffer.size() - used < 64) {
+                ok &= std::fwrite(buffer.data(), 1, used, text) == used;
+                used = 0;
+            }
+            char* end = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr;
+            *end = ' ';
+            used = end + 1 - buffer.data();
+        }
+        ok &= std::fwrite(buffer.data(), 1, used, text) == used;
+        ok &= std::fclose(text) == 0;
+        if (!ok) {
+            throw std::runtime_error("Couldn't write " + text_path.string());
+        }
+    }
+}
@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "parallel.h"
+#include "parallel_sort.h"
+
+
+// Сортировки без сравнений для целых ключей, ядро выбирается на этапе компиляции по типу:
+// 8- и 16-битные ключи - подсчётом (гистограмма на все 2^8/2^16 значений, затем значения
+// выписываются заново по счётчикам), 32- и 64-битные - поразрядной LSD-сортировкой по байтам,
+// остальное - сортировкой сравнением. Обе сортировки без сравнений выполняются за O(n) и упираются
+// в пропускную способность памяти. Параллельные варианты строят гистограммы частей на потоках пула
+// (каждая часть - своя гистограмма, без общих счётчиков) и так же по частям раскладывают элементы.
+// Порядок - по возрастанию (std::less), других компараторов ядра не принимают.
+// Маленькие массивы, на которых гистограммы дороже самой сортировки, сортируются std::sort
+
+namespace MT {
+
+    enum class SortKernel {
+        counting,
+        radix,
+        comparison
+    };
+
+
+    template <typename T>
+    constexpr MT::SortKernel sort_kernel_for() {
+        if constexpr (!std::is_integral_v<T> || std::is_same_v<T, bool>) {
+            return MT::SortKernel::comparison;
+        } else if constexpr (sizeof(T) <= 2) {
+            return MT::SortKernel::counting;
+        } else if constexpr (sizeof(T) == 4 || sizeof(T) == 8) {
+            return MT::SortKernel::radix;
+        } else {
+            return MT::SortKernel::comparison;
+        }
+    }
+
+
+    namespace detail {
+
+        // частей на поток в параллельных ядрах; гистограмма 16-битных ключей - 512 КБ на часть,
+        // поэтому частей меньше, чем в parallel.h, и не больше, чем позволяет размер массива
+        inline constexpr size_t kernel_chunks_per_thread = 2;
+        // меньшие массивы сортируются последовательно
+        inline constexpr size_t parallel_kernel_min = 1 << 16;
+
+        // беззнаковый ключ с тем же порядком, что у значения: у знаковых инвертируется знаковый бит
+        template <typename T>
+        constexpr std::make_unsigned_t<T> radix_key(T value) {
+            using Key = std::make_unsigned_t<T>;
+            Key key = static_cast<Key>(value);
+            if constexpr (std::is_signed_v<T>) {
+                key ^= Key(1) << (std::numeric_limits<Key>::digits - 1);
+            }
+            return key;
+        }
+
+        template <typename T>
+        constexpr T from_radix_key(std::make_unsigned_t<T> key) {
+            using Key = std::make_unsigned_t<T>;
+            if constexpr (std::is_signed_v<T>) {
+                key ^= Key(1) << (std::numeric_limits<Key>::digits - 1);
+            }
+            return static_cast<T>(key);
+        }
+
+        template <typename T>
+        inline constexpr size_t counting_buckets = size_t(1) << std::numeric_limits<std::make_unsigned_t<T>>::digits;
+
+        inline constexpr size_t radix_buckets = 256;
+
+        // меньшие массивы сортируются std::sort: обнуление и просмотр гистограмм дороже
+        // (границы подобраны замером, для 16-битных ключей - 4096 элементов)
+        template <typename T>
+        inline constexpr size_t counting_sort_min = counting_buckets<T> / 16;
+        inline constexpr size_t radix_sort_min = 128;
+
+        template <typename T>
+        void count_keys(std::span<const T> values, std::span<size_t> histogram) {
+            for (const T& value : values) {
+                ++histogram[radix_key(value)];
+            }
+        }
+
+        // выписывает в out ключи по гистограмме начиная с ключа first_key, пропустив skip первых
+        template <typename T>
+        void fill_keys(std::span<T> out, std::span<const size_t> histogram, size_t first_key, size_t skip) {
+            size_t written = 0;
+            for (size_t key = first_key; written < out.size(); ++key) {
+                size_t count = std::min(histogram[key] - skip, out.size() - written);
+                std::fill_n(out.begin() + written, count, from_radix_key<T>(static_cast<std::make_unsigned_t<T>>(key)));
+                written += count;
+                skip = 0;
+            }
+        }
+
+        template <typename T>
+        size_t radix_byte(const T& value, unsigned shift) {
+            return static_cast<size_t>((radix_key(value) >> shift) & 0xFF);
+        }
+
+        // все элементы попадают в одну корзину - проход ничего не меняет
+        inline bool single_bucket(std::span<const size_t> histogram, size_t size) {
+            return std::ranges::any_of(histogram, [size](size_t count) { return count == size; });
+        }
+
+        // частей параллельного ядра: по kernel_chunks_per_thread на поток, но гистограммы частей
+        // вместе не больше самого массива; 1 - сортировать последовательно
+        inline size_t kernel_chunks(size_t threads, size_t input_bytes, size_t histogram_bytes) {
+            return std::max<size_t>(1, std::min(threads * kernel_chunks_per_thread, input_bytes / histogram_bytes));
+        }
+    }
+
+
+    // сортировка подсчётом 8- и 16-битных целых
+    template <typename T>
+        requires (MT::sort_kernel_for<T>() == MT::SortKernel::counting)
+    void counting_sort(std::span<T> values) {
+        if (values.size() < detail::counting_sort_min<T>) {
+            std::sort(values.begin(), values.end());
+            return;
+        }
+        std::vector<size_t> histogram(detail::counting_buckets<T>, 0);
+        detail::count_keys<T>(values, histogram);
+        detail::fill_keys<T>(values, histogram, 0, 0);
+    }
+
+
+    // поразрядная LSD-сортировка 32- и 64-битных целых, по байту за проход через буфер того же
+    // размера; проходы, в которых все элементы попадают в одну корзину, пропускаются
+    template <typename T>
+        requires (MT::sort_kernel_for<T>() == MT::SortKernel::radix)
+    void radix_sort(std::span<T> values) {
+        if (values.size() < detail::radix_sort_min) {
+            std::sort(values.begin(), values.end());
+            return;
+        }
+        std::vector<T> buffer(values.size());
+        std::span<T> from = values;
+        std::span<T> to = buffer;
+        std::vector<size_t> offsets(detail::radix_buckets);
+        for (unsigned shift = 0; shift < sizeof(T) * 8; shift += 8) {
+            std::ranges::fill(offsets, 0);
+            for (const T& value : from) {
+                ++offsets[detail::radix_byte(value, shift)];
+            }
+            if (detail::single_bucket(offsets, from.size())) {
+                continue;
+            }
+            size_t position = 0;
+            for (size_t& offset : offsets) {
+                position += std::exchange(offset, position);
+            }
+            for (const T& value : from) {
+                to[offsets[detail::radix_byte(value, shift)]++] = value;
+            }
+            std::swap(from, to);
+        }
+        if (from.data() != values.data()) {
+            std::ranges::copy(from, values.begin());
+        }
+    }
+
+
+    // ядро, выбранное по типу элементов
+    template <typename T>
+    void sort_kernel(std::span<T> values) {
+        constexpr MT::SortKernel kernel = MT::sort_kernel_for<T>();
+        if constexpr (kernel == MT::SortKernel::counting) {
+            MT::counting_sort(values);
+        } else if constexpr (kernel == MT::SortKernel::radix) {
+            MT::radix_sort(values);
+        } else {
+            std::sort(values.begin(), values.end());
+        }
+    }
+
+
+    // Сортировка подсчётом на потоках пула: гистограммы частей строятся параллельно, складываются,
+    // и каждая часть результата выписывается своим потоком. Ограничения на вызов - как у parallel.h
+    template <typename T>
+        requires (MT::sort_kernel_for<T>() == MT::SortKernel::counting)
+    void parallel_counting_sort(MT::ThreadPool& pool, std::span<T> values) {
+        constexpr size_t buckets = detail::counting_buckets<T>;
+        size_t chunks = detail::kernel_chunks(pool.count_of_threads(), values.size_bytes(), buckets * sizeof(size_t));
+        if (chunks <= 1 || values.size() <= detail::parallel_kernel_min) {
+            MT::counting_sort(values);
+            return;
+        }
+
+        size_t grain = (values.size() + chunks - 1) / chunks;
+        chunks = (values.size() + grain - 1) / grain;
+        std::vector<std::vector<size_t>> histograms(chunks);
+        MT::parallel_for(pool, std::ranges::iota_view(size_t(0), chunks), [&](size_t chunk) {
+            histograms[chunk].assign(buckets, 0);
+            size_t first = chunk * grain;
+            detail::count_keys<T>(values.subspan(first, std::min(grain, values.size() - first)), histograms[chunk]);
+        }, 1);
+
+        // сумма гистограмм по диапазонам ключей, затем префиксные суммы - начала ключей в результате
+        std::vector<size_t> histogram(buckets, 0);
+        detail::split(pool, 0, buckets, buckets / chunks + 1, [&](size_t first_key, size_t last_key) {
+            for (const auto& partial : histograms) {
+                for (size_t key : std::ranges::iota_view(first_key, last_key)) {
+                    histogram[key] += partial[key];
+                }
+            }
+        });
+        std::vector<size_t> starts(buckets + 1, 0);
+        for (size_t key : std::ranges::iota_view(size_t(0), buckets)) {
+            starts[key + 1] = starts[key] + histogram[key];
+        }
+
+        detail::split(pool, 0, values.size(), grain, [&](size_t first, size_t last) {
+            size_t key = static_cast<size_t>(std::upper_bound(starts.begin(), starts.end(), first) - starts.begin()) - 1;
+            detail::fill_keys<T>(values.subspan(first, last - first), histogram, key, first - starts[key]);
+        });
+    }
+
+
+    // Поразрядная сортировка на потоках пула: в каждом проходе части строят свои гистограммы
+    // байта, по ним каждой части назначаются непересекающиеся места в каждой корзине, и части
+    // раскладываются параллельно (внутри корзины порядок частей сохраняется, поэтому LSD корректна)
+    template <typename T>
+        requires (MT::sort_kernel_for<T>() == MT::SortKernel::radix)
+    void parallel_radix_sort(MT::ThreadPool& pool, std::span<T> values) {
+        size_t chunks = detail::kernel_chunks(pool.count_of_threads(), values.size_bytes(),
+                                              detail::radix_buckets * sizeof(size_t));
+        if (chunks <= 1 || values.size() <= detail::parallel_kernel_min) {
+            MT::radix_sort(values);
+            return;
+        }
+
+        size_t grain = (values.size() + chunks - 1) / chunks;
+        chunks = (values.size() + grain - 1) / grain;
+        std::vector<T> buffer(values.size());
+        std::span<T> from = values;
+        std::span<T> to = buffer;
+        std::vector<std::vector<size_t>> offsets(chunks, std::vector<size_t>(detail::radix_buckets));
+        std::vector<size_t> histogram(detail::radix_buckets);
+
+        for (unsigned shift = 0; shift < sizeof(T) * 8; shift += 8) {
+            MT::parallel_for(pool, std::ranges::iota_view(size_t(0), chunks), [&](size_t chunk) {
+                std::ranges::fill(offsets[chunk], 0);
+                for (const T& value : from.subspan(chunk * grain, std::min(grain, from.size() - chunk * grain))) {
+                    ++offsets[chunk][detail::radix_byte(value, shift)];
+                }
+            }, 1);
+
+            std::ranges::fill(histogram, 0);
+            for (const auto& partial : offsets) {
+                for (size_t bucket : std::ranges::iota_view(size_t(0), detail::radix_buckets)) {
+                    histogram[bucket] += partial[bucket];
+                }
+            }
+            if (detail::single_bucket(histogram, from.size())) {
+                continue;
+            }
+            // место части в корзине - после всех меньших корзин и после предыдущих частей
+            size_t position = 0;
+            for (size_t bucket : std::ranges::iota_view(size_t(0), detail::radix_buckets)) {
+                for (auto& partial : offsets) {
+                    position += std::exchange(partial[bucket], position);
+                }
+            }
+
+            MT::parallel_for(pool, std::ranges::iota_view(size_t(0), chunks), [&](size_t chunk) {
+                std::vector<size_t>& offset = offsets[chunk];
+                for (const T& value : from.subspan(chunk * grain, std::min(grain, from.size() - chunk * grain))) {
+                    to[offset[detail::radix_byte(value, shift)]++] = value;
+                }
+            }, 1);
+            std::swap(from, to);
+        }
+        if (from.data() != values.data()) {
+            MT::parallel_transform(pool, from, values.begin(), [](const T& value) { return value; });
+        }
+    }
+
+
+    // параллельное ядро, выбранное по типу элементов; для прочих типов - MT::parallel_sort
+    template <typename T>
+    void parallel_sort_kernel(MT::ThreadPool& pool, std::span<T> values) {
+        constexpr MT::SortKernel kernel = MT::sort_kernel_for<T>();
+        if constexpr (kernel == MT::SortKernel::counting) {
+            MT::parallel_counting_sort(pool, values);
+        } else if constexpr (kernel == MT::SortKernel::radix) {
+            MT::parallel_radix_sort(pool, values);
+        } else {
+            MT::parallel_sort(pool, values.begin(), values.end());
+        }
+    }
+}
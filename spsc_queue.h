@@ -0,0 +1,192 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+namespace MT {
+
+    // Ограниченная lock-free очередь для одного производителя и одного потребителя.
+    // Каждая сторона кэширует индекс другой стороны, чтобы не трогать чужую кэш-линию без нужды.
+    // Ёмкость округляется вверх до степени двойки.
+    template <typename T>
+    class SpscQueue {
+        std::unique_ptr<T[]> buffer;
+        const size_t mask;
+
+        alignas(64) std::atomic<size_t> head;
+        size_t cached_tail;
+
+        alignas(64) std::atomic<size_t> tail;
+        size_t cached_head;
+
+        static size_t round_up(size_t capacity) {
+            size_t result = 2;
+            while (result < capacity) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+     public:
+        explicit SpscQueue(size_t capacity) :
+                buffer(new T[round_up(capacity)]), mask(round_up(capacity) - 1),
+                head(0), cached_tail(0), tail(0), cached_head(0) {}
+
+        SpscQueue(const SpscQueue& other) = delete;
+        SpscQueue& operator=(const SpscQueue& other) = delete;
+
+        // вызывается только производителем, false - очередь заполнена
+        bool try_push(T&& value) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t - cached_head > mask) {
+                cached_head = head.load(std::memory_order_acquire);
+                if (t - cached_head > mask) {
+                    return false;
+                }
+            }
+            buffer[t & mask] = std::move(value);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        // вызывается только потребителем, false - очередь пуста
+        bool try_pop(T& value) {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == cached_tail) {
+                cached_tail = tail.load(std::memory_order_acquire);
+                if (h == cached_tail) {
+                    return false;
+                }
+            }
+            value = std::move(buffer[h & mask]);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const {
+            return mask + 1;
+        }
+
+        bool empty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+    };
+
+
+    // Набор SPSC очередей "по одной на поток-производитель" с одним общим потребителем.
+    // Производитель находит свою очередь через thread_local кэш без блокировок,
+    // мьютекс берётся только при первом обращении потока.
+    // Очередь живёт, пока жив её поток: при завершении потока она помечается отработавшей,
+    // и drain освобождает её, разобрав до конца. Поэтому очередей не больше, чем живых
+    // производителей, а элементы одного потока всегда выходят в порядке добавления
+    template <typename T>
+    class PerThreadQueues {
+        inline static std::atomic<size_t> next_id{1};
+
+        // очередь делят набор и кэш потока: каждый из них может исчезнуть первым
+        struct Slot {
+            MT::SpscQueue<T> queue;
+            // поток-производитель завершился, новых элементов не будет
+            std::atomic<bool> retired{false};
+            // набор уничтожен, кэш потока может забыть очередь
+            std::atomic<bool> abandoned{false};
+
+            explicit Slot(size_t capacity) : queue(capacity) {}
+        };
+
+        // очереди текущего потока во всех наборах; при завершении потока они отдаются потребителям
+        struct LocalSlots {
+            std::vector<std::pair<size_t, std::shared_ptr<Slot>>> entries;
+
+            ~LocalSlots() {
+                for (const std::pair<size_t, std::shared_ptr<Slot>>& entry : entries) {
+                    entry.second->retired.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        // уникальный номер набора для поиска очереди текущего потока
+        const size_t id;
+        const size_t queue_capacity;
+
+        std::mutex queues_mutex;
+        std::vector<std::shared_ptr<Slot>> queues;
+
+     public:
+        explicit PerThreadQueues(size_t queue_capacity_) : id(next_id.fetch_add(1)), queue_capacity(queue_capacity_) {}
+
+        PerThreadQueues(const PerThreadQueues& other) = delete;
+        PerThreadQueues& operator=(const PerThreadQueues& other) = delete;
+
+        ~PerThreadQueues() {
+            for (const std::shared_ptr<Slot>& slot : queues) {
+                slot->abandoned.store(true, std::memory_order_release);
+            }
+        }
+
+        // очередь текущего потока, при первом обращении создаётся
+        MT::SpscQueue<T>& local() {
+            thread_local LocalSlots local_slots;
+
+            for (const std::pair<size_t, std::shared_ptr<Slot>>& entry : local_slots.entries) {
+                if (entry.first == id) {
+                    return entry.second->queue;
+                }
+            }
+
+            // кэш растёт только с числом наборов, в которые поток пишет; очереди уничтоженных наборов забываются
+            std::erase_if(local_slots.entries, [](const std::pair<size_t, std::shared_ptr<Slot>>& entry) -> bool {
+                return entry.second->abandoned.load(std::memory_order_acquire);
+            });
+
+            std::shared_ptr<Slot> slot = std::make_shared<Slot>(queue_capacity);
+            {
+                std::lock_guard<std::mutex> qm(queues_mutex);
+                queues.push_back(slot);
+            }
+            local_slots.entries.emplace_back(id, slot);
+            return slot->queue;
+        }
+
+        // число очередей, ещё не освобождённых drain
+        size_t queue_count() {
+            std::lock_guard<std::mutex> qm(queues_mutex);
+            return queues.size();
+        }
+
+        // разбирает все очереди, вызывая consumer для каждого элемента, и освобождает
+        // опустевшие очереди завершившихся потоков. Одновременно может работать только один потребитель
+        template <typename Consumer>
+        size_t drain(Consumer&& consumer) {
+            std::vector<std::shared_ptr<Slot>> snapshot;
+            {
+                std::lock_guard<std::mutex> qm(queues_mutex);
+                snapshot = queues;
+            }
+
+            size_t drained = 0;
+            bool has_retired = false;
+            T value;
+            for (const std::shared_ptr<Slot>& slot : snapshot) {
+                while (slot->queue.try_pop(value)) {
+                    consumer(value);
+                    ++drained;
+                }
+                has_retired = has_retired || slot->retired.load(std::memory_order_acquire);
+            }
+
+            // после retired поток в очередь не пишет, поэтому пустая отработавшая очередь пуста навсегда
+            if (has_retired) {
+                std::lock_guard<std::mutex> qm(queues_mutex);
+                std::erase_if(queues, [](const std::shared_ptr<Slot>& slot) -> bool {
+                    return slot->retired.load(std::memory_order_acquire) && slot->queue.empty();
+                });
+            }
+            return drained;
+        }
+    };
+}
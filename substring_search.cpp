@@ -0,0 +1,337 @@
+#include "substring_search.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <ranges>
+#include <stdexcept>
+#include "pipeline.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#include <immintrin.h>
+#define MT_HAS_SSE2 1
+// AVX2-ядра компилируются атрибутом target и включаются только при поддержке процессором
+#if defined(__GNUC__)
+#define MT_HAS_AVX2 1
+#endif
+#endif
+
+
+namespace {
+
+	using FindFunction = size_t (*)(const char* text, size_t size, const char* pattern, size_t pattern_size, size_t from);
+	using CountFunction = size_t (*)(const char* text, size_t size);
+
+	constexpr size_t npos = std::string_view::npos;
+
+
+	// кандидат с совпавшими первым и последним байтом - сравниваются байты между ними
+	bool inner_equal(const char* candidate, const char* pattern, size_t pattern_size) {
+		return pattern_size <= 2 || std::memcmp(candidate + 1, pattern + 1, pattern_size - 2) == 0;
+	}
+
+
+	size_t find_scalar(const char* text, size_t size, const char* pattern, size_t pattern_size, size_t from) {
+		if (pattern_size == 0 || size < pattern_size || from > size - pattern_size) {
+			return npos;
+		}
+		const char* last_start = text + (size - pattern_size);
+		const char* position = text + from;
+		while (position <= last_start) {
+			position = static_cast<const char*>(std::memchr(position, pattern[0], last_start - position + 1));
+			if (position == nullptr) {
+				return npos;
+			}
+			if (position[pattern_size - 1] == pattern[pattern_size - 1] && inner_equal(position, pattern, pattern_size)) {
+				return position - text;
+			}
+			++position;
+		}
+		return npos;
+	}
+
+
+	size_t count_scalar(const char* text, size_t size) {
+		return static_cast<size_t>(std::count(text, text + size, '\n'));
+	}
+
+
+#ifdef MT_HAS_SSE2
+	size_t find_sse2(const char* text, size_t size, const char* pattern, size_t pattern_size, size_t from) {
+		if (pattern_size == 0 || size < pattern_size) {
+			return npos;
+		}
+		const __m128i first = _mm_set1_epi8(pattern[0]);
+		const __m128i last = _mm_set1_epi8(pattern[pattern_size - 1]);
+		size_t i = from;
+		// блок - 16 позиций начала, последнему байту образца в блоке нужно i + 15 + pattern_size - 1 < size
+		for (; i + 16 + pattern_size - 1 <= size; i += 16) {
+			__m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			__m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + pattern_size - 1));
+			unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+			while (mask != 0) {
+				size_t candidate = i + std::countr_zero(mask);
+				if (inner_equal(text + candidate, pattern, pattern_size)) {
+					return candidate;
+				}
+				mask &= mask - 1;
+			}
+		}
+		return find_scalar(text, size, pattern, pattern_size, i);
+	}
+
+
+	size_t count_sse2(const char* text, size_t size) {
+		const __m128i newline = _mm_set1_epi8('\n');
+		size_t count = 0;
+		size_t i = 0;
+		for (; i + 16 <= size; i += 16) {
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			count += std::popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline))));
+		}
+		return count + count_scalar(text + i, size - i);
+	}
+#endif
+
+
+#ifdef MT_HAS_AVX2
+	__attribute__((target("avx2")))
+	size_t find_avx2(const char* text, size_t size, const char* pattern, size_t pattern_size, size_t from) {
+		if (pattern_size == 0 || size < pattern_size) {
+			return npos;
+		}
+		const __m256i first = _mm256_set1_epi8(pattern[0]);
+		const __m256i last = _mm256_set1_epi8(pattern[pattern_size - 1]);
+		size_t i = from;
+		for (; i + 32 + pattern_size - 1 <= size; i += 32) {
+			__m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+			__m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + pattern_size - 1));
+			unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+				_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+			while (mask != 0) {
+				size_t candidate = i + std::countr_zero(mask);
+				if (inner_equal(text + candidate, pattern, pattern_size)) {
+					return candidate;
+				}
+				mask &= mask - 1;
+			}
+		}
+		return find_sse2(text, size, pattern, pattern_size, i);
+	}
+
+
+	__attribute__((target("avx2")))
+	size_t count_avx2(const char* text, size_t size) {
+		const __m256i newline = _mm256_set1_epi8('\n');
+		size_t count = 0;
+		size_t i = 0;
+		for (; i + 32 <= size; i += 32) {
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+			count += std::popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline))));
+		}
+		return count + count_sse2(text + i, size - i);
+	}
+#endif
+
+
+	struct SearchKernels {
+		const char* name;
+		FindFunction find;
+		CountFunction count;
+	};
+
+
+	SearchKernels select_kernels() {
+#ifdef MT_HAS_AVX2
+		if (__builtin_cpu_supports("avx2")) {
+			return {"avx2", find_avx2, count_avx2};
+		}
+#endif
+#ifdef MT_HAS_SSE2
+		return {"sse2", find_sse2, count_sse2};
+#else
+		return {"scalar", find_scalar, count_scalar};
+#endif
+	}
+
+
+	const SearchKernels& kernels() {
+		static const SearchKernels selected = select_kernels();
+		return selected;
+	}
+
+
+	// Поиск по частям текста конвейером: номера частей по порядку выдаёт источник, find_in_chunk(first, length)
+	// ищет вхождения, начинающиеся в части (по возрастанию offset), и считает переводы строк всей части
+	// параллельно, а последовательная стадия в порядке частей только складывает их счётчики и нумерует
+	// строки вхождений. В обработке не больше Pipeline::tokens() частей
+	template <typename Match, typename FindInChunk>
+	std::vector<Match> search_chunks(MT::ThreadPool& pool, std::string_view text, size_t chunk_bytes,
+									 const FindInChunk& find_in_chunk) {
+		struct ChunkMatches {
+			// match.line - переводов строк в части до вхождения
+			std::vector<Match> matches;
+			// переводов строк во всей части
+			size_t newlines;
+		};
+
+		chunk_bytes = std::max<size_t>(1, chunk_bytes);
+		size_t next_chunk = 0;
+		std::vector<Match> matches;
+		// переводов строк в уже пройденных частях
+		size_t lines_before = 0;
+
+		MT::Pipeline(pool).run(
+			[&]() -> std::optional<size_t> {
+				if (next_chunk * chunk_bytes >= text.size()) {
+					return std::nullopt;
+				}
+				return next_chunk++;
+			},
+			MT::parallel_stage([&](size_t chunk) {
+				size_t first = chunk * chunk_bytes;
+				size_t last = std::min(text.size(), first + chunk_bytes);
+				ChunkMatches part{find_in_chunk(first, last - first), 0};
+				size_t position = first;
+				for (Match& match : part.matches) {
+					part.newlines += MT::count_newlines(text.substr(position, match.offset - position));
+					position = match.offset;
+					match.line = part.newlines;
+				}
+				part.newlines += MT::count_newlines(text.substr(position, last - position));
+				return part;
+			}),
+			MT::serial_stage([&](ChunkMatches part) {
+				for (Match& match : part.matches) {
+					match.line += 1 + lines_before;
+					matches.push_back(match);
+				}
+				lines_before += part.newlines;
+			}));
+		return matches;
+	}
+}
+
+
+MT::SubstringSearcher::SubstringSearcher(std::string pattern_) :
+	pattern(std::move(pattern_)), find_function(kernels().find) {}
+
+
+size_t MT::count_newlines(std::string_view text) {
+	return kernels().count(text.data(), text.size());
+}
+
+
+const char* MT::substring_search_kernel() {
+	return kernels().name;
+}
+
+
+std::vector<MT::TextMatch> MT::parallel_search(MT::ThreadPool& pool, std::string_view text,
+											   const MT::SubstringSearcher& searcher, size_t chunk_bytes) {
+	return search_chunks<MT::TextMatch>(pool, text, chunk_bytes, [&](size_t first, size_t length) {
+		std::vector<MT::TextMatch> found;
+		std::string_view window = text.substr(first, length + searcher.size() - 1);
+		for (size_t position = searcher.find(window); position < length; position = searcher.find(window, position + 1)) {
+			found.push_back({first + position, 0});
+		}
+		return found;
+	});
+}
+
+
+MT::MultiPatternSearcher::MultiPatternSearcher(std::vector<std::string> patterns_) : patterns_list(std::move(patterns_)) {
+	for (const std::string& pattern : patterns_list) {
+		longest = std::max(longest, pattern.size());
+		for (char byte : pattern) {
+			uint16_t& byte_class_ref = byte_class[static_cast<unsigned char>(byte)];
+			if (byte_class_ref == 0) {
+				byte_class_ref = static_cast<uint16_t>(classes++);
+			}
+		}
+	}
+
+	// бор образцов: переход в 0 - перехода нет (в корень никто не переходит по бору)
+	std::vector<uint32_t> next(classes, 0);
+	std::vector<std::vector<uint32_t>> own_outputs(1);
+	for (size_t index : std::ranges::iota_view(size_t(0), patterns_list.size())) {
+		if (patterns_list[index].empty()) {
+			continue;
+		}
+		size_t state = 0;
+		for (char byte : patterns_list[index]) {
+			size_t slot = state * classes + byte_class[static_cast<unsigned char>(byte)];
+			if (next[slot] == 0) {
+				next[slot] = static_cast<uint32_t>(own_outputs.size());
+				own_outputs.emplace_back();
+				next.resize(next.size() + classes, 0);
+			}
+			state = next[slot];
+		}
+		own_outputs[state].push_back(static_cast<uint32_t>(index));
+	}
+	size_t states_count = own_outputs.size();
+	if (states_count * classes > row_mask) {
+		throw std::length_error("Too many patterns for MultiPatternSearcher");
+	}
+
+	// обход в ширину: суффиксная ссылка состояния короче его самого, поэтому её строка
+	// к этому моменту уже достроена, и недостающие переходы берутся из неё
+	std::vector<uint32_t> fail(states_count, 0);
+	std::vector<std::vector<uint32_t>> all_outputs(states_count);
+	std::vector<uint32_t> order;
+	order.reserve(states_count);
+	order.push_back(0);
+	for (size_t head = 0; head < order.size(); ++head) {
+		uint32_t state = order[head];
+		all_outputs[state] = own_outputs[state];
+		if (state != 0) {
+			const auto& inherited = all_outputs[fail[state]];
+			all_outputs[state].insert(all_outputs[state].end(), inherited.begin(), inherited.end());
+		}
+		for (size_t symbol : std::ranges::iota_view(size_t(0), classes)) {
+			uint32_t& target = next[state * classes + symbol];
+			uint32_t fallback = state == 0 ? 0 : next[fail[state] * classes + symbol];
+			if (target != 0) {
+				fail[target] = fallback;
+				order.push_back(target);
+			} else {
+				target = fallback;
+			}
+		}
+	}
+
+	output_begin.assign(states_count + 1, 0);
+	for (size_t state : std::ranges::iota_view(size_t(0), states_count)) {
+		output_begin[state + 1] = output_begin[state] + static_cast<uint32_t>(all_outputs[state].size());
+		outputs.insert(outputs.end(), all_outputs[state].begin(), all_outputs[state].end());
+	}
+	transitions.resize(next.size());
+	for (size_t slot : std::ranges::iota_view(size_t(0), next.size())) {
+		uint32_t target = next[slot];
+		transitions[slot] = target * static_cast<uint32_t>(classes) | (all_outputs[target].empty() ? 0 : output_flag);
+	}
+}
+
+
+std::vector<MT::PatternMatch> MT::parallel_search(MT::ThreadPool& pool, std::string_view text,
+												  const MT::MultiPatternSearcher& searcher, size_t chunk_bytes) {
+	size_t overlap = std::max<size_t>(1, searcher.max_size()) - 1;
+	const std::vector<std::string>& patterns = searcher.patterns();
+
+	return search_chunks<MT::PatternMatch>(pool, text, chunk_bytes, [&](size_t first, size_t length) {
+		std::vector<MT::PatternMatch> found;
+		// автомат стартует с начала части, поэтому вхождения, начавшиеся в предыдущей, не находятся
+		searcher.scan(text.substr(first, length + overlap), [&](size_t pattern, size_t end) {
+			size_t start = end - patterns[pattern].size();
+			if (start < length) {
+				found.push_back({pattern, first + start, 0});
+			}
+		});
+		// вхождения сообщаются по концу, а номера строк считаются по началу
+		std::ranges::sort(found, [](const MT::PatternMatch& a, const MT::PatternMatch& b) {
+			return a.offset != b.offset ? a.offset < b.offset : a.pattern < b.pattern;
+		});
+		return found;
+	});
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "thread_pool.h"
+
+
+// Поиск подстроки в больших текстах (например, в файле, отображённом в память).
+// Кандидаты отбираются фильтром по первому и последнему байту образца сразу для 32 (AVX2)
+// или 16 (SSE2) позиций, полностью сравниваются только они; ядро выбирается один раз при запуске
+// по возможностям процессора, без SIMD - скалярный поиск через memchr.
+// Номера строк получаются подсчётом переводов строк теми же SIMD в каждой части параллельно.
+// Несколько образцов ищутся за один проход автоматом Ахо-Корасик (MultiPatternSearcher)
+
+namespace MT {
+
+    // Образец, подготовленный к поиску один раз на весь поиск
+    class SubstringSearcher {
+        using FindFunction = size_t (*)(const char* text, size_t size, const char* pattern, size_t pattern_size, size_t from);
+
+        std::string pattern;
+        FindFunction find_function;
+
+     public:
+        explicit SubstringSearcher(std::string pattern_);
+
+        size_t size() const {
+            return pattern.size();
+        }
+
+        // начало первого вхождения не раньше from или std::string_view::npos; пустой образец не находится
+        size_t find(std::string_view text, size_t from = 0) const {
+            return find_function(text.data(), text.size(), pattern.data(), pattern.size(), from);
+        }
+    };
+
+
+    // число символов '\n' в тексте
+    size_t count_newlines(std::string_view text);
+
+    // выбранное ядро: "avx2", "sse2" или "scalar"
+    const char* substring_search_kernel();
+
+
+    struct TextMatch {
+        // смещение начала вхождения в тексте
+        size_t offset;
+        // номер строки вхождения, с 1
+        size_t line;
+    };
+
+    // части текста по 256 КБ помещаются в кэш L2
+    inline constexpr size_t search_chunk_bytes = size_t(256) << 10;
+
+    // Автомат Ахо-Корасик для набора образцов: переходы по всем байтам заранее достроены через
+    // суффиксные ссылки и лежат одной плоской таблицей, поэтому на байт текста - одно чтение
+    // таблицы независимо от числа образцов. Байты, которых нет в образцах, объединены в один класс,
+    // и строка таблицы занимает (число различных байтов образцов + 1) переходов
+    class MultiPatternSearcher {
+        // в переходе: номер первого перехода строки следующего состояния и флаг "есть вхождения"
+        static constexpr uint32_t output_flag = uint32_t(1) << 31;
+        static constexpr uint32_t row_mask = output_flag - 1;
+
+        std::vector<std::string> patterns_list;
+        std::array<uint16_t, 256> byte_class{};
+        size_t classes = 1;
+        std::vector<uint32_t> transitions;
+        // образцы, оканчивающиеся в состоянии s: outputs[output_begin[s] .. output_begin[s + 1])
+        std::vector<uint32_t> output_begin;
+        std::vector<uint32_t> outputs;
+        size_t longest = 0;
+
+     public:
+        // пустые образцы не находятся; одинаковые образцы находятся каждый под своим номером
+        explicit MultiPatternSearcher(std::vector<std::string> patterns_);
+
+        const std::vector<std::string>& patterns() const {
+            return patterns_list;
+        }
+
+        // длина самого длинного образца
+        size_t max_size() const {
+            return longest;
+        }
+
+        size_t states() const {
+            return output_begin.size() - 1;
+        }
+
+        // found(pattern, end) для каждого вхождения; end - смещение за последним байтом вхождения.
+        // Вхождения сообщаются в порядке возрастания end
+        template <typename Found>
+        void scan(std::string_view text, Found&& found) const {
+            uint32_t row = 0;
+            for (size_t i : std::ranges::iota_view(size_t(0), text.size())) {
+                uint32_t next = transitions[row + byte_class[static_cast<unsigned char>(text[i])]];
+                row = next & row_mask;
+                if ((next & output_flag) != 0) {
+                    size_t state = row / classes;
+                    for (uint32_t k : std::ranges::iota_view(output_begin[state], output_begin[state + 1])) {
+                        found(static_cast<size_t>(outputs[k]), i + 1);
+                    }
+                }
+            }
+        }
+    };
+
+
+    // Все вхождения (в том числе перекрывающиеся) в порядке возрастания смещения. Текст делится
+    // на части по chunk_bytes, каждая просматривается с захватом size() - 1 байт следующей части,
+    // чтобы не потерять вхождения на границе. Части проходят через MT::Pipeline, поэтому
+    // одновременно в работе ограниченное число частей. Ограничения на вызов - как у алгоритмов parallel.h
+    std::vector<MT::TextMatch> parallel_search(MT::ThreadPool& pool, std::string_view text,
+                                               const MT::SubstringSearcher& searcher,
+                                               size_t chunk_bytes = MT::search_chunk_bytes);
+
+
+    struct PatternMatch {
+        // номер образца в MultiPatternSearcher::patterns()
+        size_t pattern;
+        size_t offset;
+        size_t line;
+    };
+
+    // Вхождения всех образцов за один проход по тексту, в порядке возрастания смещения (при
+    // равных смещениях - номера образца). Части текста захватывают max_size() - 1 байт следующей
+    // части; вхождение относится к части, в которой начинается
+    std::vector<MT::PatternMatch> parallel_search(MT::ThreadPool& pool, std::string_view text,
+                                                  const MT::MultiPatternSearcher& searcher,
+                                                  size_t chunk_bytes = MT::search_chunk_bytes);
+}
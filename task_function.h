@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace MT {
+
+    // Перемещаемая, но не копируемая обёртка над вызываемым объектом без аргументов
+    // (аналог std::move_only_function<void()>). Объекты до inline_size байт хранятся
+    // прямо внутри обёртки, без выделения памяти; большие - в куче.
+    class TaskFunction {
+     public:
+        static constexpr size_t inline_size = 64;
+
+     private:
+        struct VTable {
+            void (*invoke)(void* storage);
+            // переносит объект из src в неинициализированный dst и разрушает src
+            void (*relocate)(void* dst, void* src) noexcept;
+            void (*destroy)(void* storage) noexcept;
+        };
+
+        template <typename F>
+        static constexpr bool fits_inline = sizeof(F) <= inline_size &&
+                                            alignof(F) <= alignof(std::max_align_t) &&
+                                            std::is_nothrow_move_constructible_v<F>;
+
+        template <typename F>
+        static constexpr VTable inline_vtable = {
+            [](void* storage) { (*std::launder(static_cast<F*>(storage)))(); },
+            [](void* dst, void* src) noexcept {
+                F* source = std::launder(static_cast<F*>(src));
+                ::new (dst) F(std::move(*source));
+                source->~F();
+            },
+            [](void* storage) noexcept { std::launder(static_cast<F*>(storage))->~F(); }
+        };
+
+        template <typename F>
+        static constexpr VTable heap_vtable = {
+            [](void* storage) { (**static_cast<F**>(storage))(); },
+            [](void* dst, void* src) noexcept { ::new (dst) F*(*static_cast<F**>(src)); },
+            [](void* storage) noexcept { delete *static_cast<F**>(storage); }
+        };
+
+        alignas(std::max_align_t) unsigned char storage[inline_size];
+        const VTable* vtable = nullptr;
+
+     public:
+        TaskFunction() = default;
+
+        template <typename F>
+            requires (!std::is_same_v<std::decay_t<F>, TaskFunction> && std::is_invocable_v<std::decay_t<F>&>)
+        TaskFunction(F&& f) {
+            using Fn = std::decay_t<F>;
+            if constexpr (fits_inline<Fn>) {
+                ::new (static_cast<void*>(storage)) Fn(std::forward<F>(f));
+                vtable = &inline_vtable<Fn>;
+            } else {
+                ::new (static_cast<void*>(storage)) Fn*(new Fn(std::forward<F>(f)));
+                vtable = &heap_vtable<Fn>;
+            }
+        }
+
+        TaskFunction(const TaskFunction& other) = delete;
+        TaskFunction& operator=(const TaskFunction& other) = delete;
+
+        TaskFunction(TaskFunction&& other) noexcept : vtable(other.vtable) {
+            if (vtable != nullptr) {
+                vtable->relocate(storage, other.storage);
+                other.vtable = nullptr;
+            }
+        }
+
+        TaskFunction& operator=(TaskFunction&& other) noexcept {
+            if (this != &other) {
+                reset();
+                vtable = other.vtable;
+                if (vtable != nullptr) {
+                    vtable->relocate(storage, other.storage);
+                    other.vtable = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        ~TaskFunction() {
+            reset();
+        }
+
+        void operator()() {
+            vtable->invoke(storage);
+        }
+
+        // разрушает хранимый объект
+        void reset() noexcept {
+            if (vtable != nullptr) {
+                vtable->destroy(storage);
+                vtable = nullptr;
+            }
+        }
+
+        explicit operator bool() const {
+            return vtable != nullptr;
+        }
+    };
+}
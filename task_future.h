@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+
+namespace MT {
+
+    // Общее состояние задачи и её TaskFuture, одно выделение памяти на задачу.
+    // Результат публикуется одной release-записью в status и notify_all.
+    template <typename R>
+    class FutureState {
+        using Value = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+        enum Status : uint8_t {
+            pending,
+            value_ready,
+            exception_ready
+        };
+
+        std::atomic<uint8_t> status{pending};
+        std::optional<Value> value;
+        std::exception_ptr exception;
+
+     public:
+        template <typename... ValueArgs>
+        void set_value(ValueArgs&&... args) {
+            value.emplace(std::forward<ValueArgs>(args)...);
+            status.store(value_ready, std::memory_order_release);
+            status.notify_all();
+        }
+
+        void set_exception(std::exception_ptr exception_) {
+            exception = std::move(exception_);
+            status.store(exception_ready, std::memory_order_release);
+            status.notify_all();
+        }
+
+        bool is_ready() const {
+            return status.load(std::memory_order_acquire) != pending;
+        }
+
+        void wait() const {
+            uint8_t current = status.load(std::memory_order_acquire);
+            while (current == pending) {
+                status.wait(pending, std::memory_order_acquire);
+                current = status.load(std::memory_order_acquire);
+            }
+        }
+
+        // забирает результат, вызывается не более одного раза
+        R take() {
+            wait();
+            if (status.load(std::memory_order_acquire) == exception_ready) {
+                std::rethrow_exception(exception);
+            }
+            if constexpr (!std::is_void_v<R>) {
+                return std::move(*value);
+            }
+        }
+    };
+
+
+    // Лёгкий дескриптор результата задачи, добавленной через ThreadPool::submit
+    template <typename R>
+    class TaskFuture {
+        std::shared_ptr<MT::FutureState<R>> state;
+        size_t task_id = 0;
+
+     public:
+        TaskFuture() = default;
+
+        TaskFuture(std::shared_ptr<MT::FutureState<R>> state_, size_t task_id_) : state(std::move(state_)), task_id(task_id_) {}
+
+        bool valid() const {
+            return state != nullptr;
+        }
+
+        bool is_ready() const {
+            return state->is_ready();
+        }
+
+        // блокирует текущий поток до готовности результата
+        void wait() const {
+            state->wait();
+        }
+
+        // результат задачи или её исключение; после вызова TaskFuture становится пустым
+        R get() {
+            std::shared_ptr<MT::FutureState<R>> current = std::move(state);
+            return current->take();
+        }
+
+        // 0, если задача была отклонена переполненной очередью
+        size_t id() const {
+            return task_id;
+        }
+    };
+}
@@ -0,0 +1,206 @@
+#include "task_graph.h"
+#include <stdexcept>
+
+
+MT::TaskGraph::TaskGraph() : checked(true), pool(nullptr), pending(0), helpers(0) {}
+
+
+MT::TaskGraph::~TaskGraph() {
+	wait_all();
+}
+
+
+void MT::TaskGraph::Node::on_job_finished(std::exception_ptr error) {
+	graph.finish_node(*this, std::move(error));
+}
+
+
+void MT::TaskGraph::precede(NodeId before, NodeId after) {
+	if (before >= nodes.size() || after >= nodes.size()) {
+		throw std::out_of_range("Unknown node of the task graph");
+	}
+	if (pending.load() != 0) {
+		throw std::logic_error("The task graph cannot be changed while it is running");
+	}
+	nodes[before].successors.push_back(&nodes[after]);
+	++nodes[after].in_degree;
+	checked = false;
+}
+
+
+size_t MT::TaskGraph::size() const {
+	return nodes.size();
+}
+
+
+void MT::TaskGraph::check() {
+	// алгоритм Кана: если обойти удалось не все узлы, в графе есть цикл
+	std::vector<size_t> in_degree(nodes.size());
+	std::vector<size_t> ready;
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), nodes.size())) {
+		in_degree[i] = nodes[i].in_degree;
+		if (in_degree[i] == 0) {
+			ready.push_back(i);
+		}
+	}
+
+	size_t visited = 0;
+	while (!ready.empty()) {
+		size_t current = ready.back();
+		ready.pop_back();
+		++visited;
+		for (Node* next : nodes[current].successors) {
+			if (--in_degree[next->index] == 0) {
+				ready.push_back(next->index);
+			}
+		}
+	}
+
+	if (visited != nodes.size()) {
+		throw std::logic_error("The task graph contains a cycle");
+	}
+	checked = true;
+}
+
+
+void MT::TaskGraph::launch(MT::ThreadPool& pool_) {
+	if (pending.load() != 0) {
+		throw std::logic_error("The task graph is already running");
+	}
+	if (!checked) {
+		check();
+	}
+
+	pool = &pool_;
+	{
+		std::lock_guard<std::mutex> em(error_mutex);
+		error = nullptr;
+	}
+	if (nodes.empty()) {
+		return;
+	}
+
+	std::vector<Node*> roots;
+	for (Node& node : nodes) {
+		node.remaining.store(node.in_degree, std::memory_order_relaxed);
+		node.cancelled.store(false, std::memory_order_relaxed);
+		if (node.in_degree == 0) {
+			roots.push_back(&node);
+		}
+	}
+	pending.store(nodes.size());
+
+	// все корни уходят в пул одной пакетной операцией
+	dispatch(roots);
+}
+
+
+void MT::TaskGraph::dispatch(const std::vector<Node*>& ready) {
+	if (ready.size() == 1) {
+		Node* node = ready.front();
+		pool->push_job(MT::TaskFunction([node]() { node->fn(); }), node->task.get(), node);
+		return;
+	}
+
+	std::vector<MT::Job*> jobs(ready.size());
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), ready.size())) {
+		Node* node = ready[i];
+		jobs[i] = MT::JobPool::allocate();
+		jobs[i]->fn = MT::TaskFunction([node]() { node->fn(); });
+		jobs[i]->task = node->task.get();
+		jobs[i]->listener = node;
+	}
+	pool->push_jobs(std::move(jobs));
+}
+
+
+void MT::TaskGraph::finish_node(Node& node, std::exception_ptr node_error) {
+	bool failed = node_error != nullptr;
+	if (failed) {
+		std::lock_guard<std::mutex> em(error_mutex);
+		if (!error) {
+			error = std::move(node_error);
+		}
+	}
+
+	// последователи, готовые к запуску, и пропущенные из-за ошибки узлы
+	std::vector<Node*> ready;
+	std::vector<Node*> skipped;
+
+	auto release_successors = [&ready, &skipped](Node& current, bool cancel) {
+		for (Node* next : current.successors) {
+			if (cancel) {
+				// пометка видна последнему предшественнику через fetch_sub ниже
+				next->cancelled.store(true);
+			}
+			if (next->remaining.fetch_sub(1) == 1) {
+				if (next->cancelled.load()) {
+					skipped.push_back(next);
+				} else {
+					ready.push_back(next);
+				}
+			}
+		}
+	};
+
+	size_t finished = 1;
+	release_successors(node, failed);
+	while (!skipped.empty()) {
+		Node* current = skipped.back();
+		skipped.pop_back();
+		++finished;
+		release_successors(*current, true);
+	}
+
+	if (!ready.empty()) {
+		dispatch(ready);
+	}
+
+	// как и в TaskGroup, счётчик уменьшается под done_mutex, чтобы граф не разрушили раньше времени
+	std::lock_guard<std::mutex> dm(done_mutex);
+	if (pending.fetch_sub(finished) == finished) {
+		done_cv.notify_all();
+		if (helpers.load() != 0) {
+			pool->wake_helpers();
+		}
+	}
+}
+
+
+void MT::TaskGraph::wait_all() {
+	while (pending.load() != 0) {
+		if (pool->run_pending_task()) {
+			continue;
+		}
+
+		if (pool->is_pool_thread()) {
+			// как в TaskGroup: спим вместе с простаивающими потоками до новой работы или завершения графа
+			helpers.fetch_add(1);
+			pool->sleep_until_work([this]() -> bool { return pending.load() == 0; });
+			helpers.fetch_sub(1);
+		} else {
+			std::unique_lock<std::mutex> lock(done_mutex);
+			done_cv.wait(lock, [this]() -> bool { return pending.load() == 0; });
+		}
+	}
+	std::lock_guard<std::mutex> dm(done_mutex);
+}
+
+
+void MT::TaskGraph::wait() {
+	wait_all();
+
+	std::exception_ptr current_error;
+	{
+		std::lock_guard<std::mutex> em(error_mutex);
+		current_error = std::exchange(error, nullptr);
+	}
+	if (current_error) {
+		std::rethrow_exception(current_error);
+	}
+}
+
+
+bool MT::TaskGraph::is_done() const {
+	return pending.load() == 0;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "thread_pool.h"
+
+
+namespace MT {
+
+    // Граф зависимостей задач. Узлы и рёбра описываются один раз, после чего граф можно
+    // многократно запускать через ThreadPool::run_graph. Узел ставится в очередь пула в тот момент,
+    // когда завершается последний из его предшественников (атомарный счётчик входящих рёбер),
+    // так что ни один поток не блокируется в ожидании зависимостей.
+    // Если узел завершился с исключением, зависящие от него узлы не запускаются
+    class TaskGraph {
+        friend class ThreadPool;
+
+        struct Node : public MT::JobListener {
+            MT::TaskGraph& graph;
+            // номер узла в nodes
+            size_t index;
+            MT::TaskFunction fn;
+            // задача-наследник Task, если узел добавлен через add(std::shared_ptr<TaskChild>)
+            std::shared_ptr<MT::Task> task;
+
+            std::vector<Node*> successors;
+            size_t in_degree = 0;
+
+            // число ещё не завершённых предшественников в текущем запуске
+            std::atomic<size_t> remaining{0};
+            // один из предшественников завершился с ошибкой или был пропущен
+            std::atomic<bool> cancelled{false};
+
+            Node(MT::TaskGraph& graph_, size_t index_, MT::TaskFunction&& fn_, std::shared_ptr<MT::Task> task_) :
+                graph(graph_), index(index_), fn(std::move(fn_)), task(std::move(task_)) {}
+
+            void on_job_finished(std::exception_ptr error) override;
+        };
+
+        // deque не перемещает узлы при добавлении новых
+        std::deque<Node> nodes;
+
+        // граф проверен на циклы после последнего изменения
+        bool checked;
+
+        // пул текущего запуска
+        MT::ThreadPool* pool;
+
+        // число узлов текущего запуска, которые ещё не выполнены и не пропущены
+        std::atomic<size_t> pending;
+
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        // потоки пула, ждущие граф в ThreadPool::sleep_until_work
+        std::atomic<size_t> helpers;
+
+        // первое исключение текущего запуска
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        // проверка ацикличности, std::logic_error при наличии цикла
+        void check();
+
+        // ставит в очередь узлы, у которых не осталось невыполненных предшественников
+        void dispatch(const std::vector<Node*>& ready);
+
+        // учитывает завершение узла и запускает или пропускает его последователей
+        void finish_node(Node& node, std::exception_ptr node_error);
+
+        // запуск графа в пуле, вызывается из ThreadPool::run_graph
+        void launch(MT::ThreadPool& pool_);
+
+        void wait_all();
+
+     public:
+        using NodeId = size_t;
+
+        TaskGraph();
+
+        TaskGraph(const TaskGraph& other) = delete;
+        TaskGraph& operator=(const TaskGraph& other) = delete;
+
+        // узел из вызываемого объекта, который вызывается при каждом запуске графа
+        template <typename F>
+            requires std::is_invocable_v<std::decay_t<F>&>
+        NodeId add(F&& f) {
+            nodes.emplace_back(*this, nodes.size(), MT::TaskFunction(std::forward<F>(f)), nullptr);
+            checked = false;
+            return nodes.size() - 1;
+        }
+
+
+        // узел из наследника Task, при каждом запуске выполняется его one_thread_method
+        template <typename TaskChild>
+            requires std::derived_from<TaskChild, MT::Task>
+        NodeId add(std::shared_ptr<TaskChild> task) {
+            MT::Task* raw_task = task.get();
+            nodes.emplace_back(*this, nodes.size(), MT::TaskFunction([raw_task]() { raw_task->one_thread_pre_method(); }),
+                               std::move(task));
+            checked = false;
+            return nodes.size() - 1;
+        }
+
+
+        // after запускается только после завершения before
+        void precede(NodeId before, NodeId after);
+
+        size_t size() const;
+
+        // ждёт завершения текущего запуска (из потока пула - выполняя задачи пула)
+        // и пробрасывает первое исключение из узлов
+        void wait();
+
+        bool is_done() const;
+
+        ~TaskGraph();
+    };
+}
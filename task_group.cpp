@@ -0,0 +1,70 @@
+#include "task_group.h"
+
+
+MT::TaskGroup::TaskGroup(MT::ThreadPool& pool_) : pool(pool_), pending(0), helpers(0) {}
+
+
+MT::TaskGroup::~TaskGroup() {
+	wait_all();
+}
+
+
+void MT::TaskGroup::on_job_finished(std::exception_ptr job_error) {
+	if (job_error) {
+		std::lock_guard<std::mutex> em(error_mutex);
+		if (!error) {
+			error = std::move(job_error);
+		}
+	}
+	// уменьшаем счётчик под done_mutex: ожидающий поток захватывает его перед выходом,
+	// поэтому группа не будет разрушена, пока мы её ещё используем
+	std::lock_guard<std::mutex> dm(done_mutex);
+	if (pending.fetch_sub(1) == 1) {
+		done_cv.notify_all();
+		// ждущий поток пула сначала увеличивает helpers, потом проверяет pending, а здесь наоборот,
+		// поэтому хотя бы одна сторона увидит другую
+		if (helpers.load() != 0) {
+			pool.wake_helpers();
+		}
+	}
+}
+
+
+void MT::TaskGroup::wait_all() {
+	while (pending.load() != 0) {
+		// поток пула не простаивает, а выполняет задачи из очередей
+		if (pool.run_pending_task()) {
+			continue;
+		}
+
+		if (pool.is_pool_thread()) {
+			// задачи группы выполняют другие потоки; пока мы ждём, в очередях может появиться новая работа
+			helpers.fetch_add(1);
+			pool.sleep_until_work([this]() -> bool { return pending.load() == 0; });
+			helpers.fetch_sub(1);
+		} else {
+			std::unique_lock<std::mutex> lock(done_mutex);
+			done_cv.wait(lock, [this]() -> bool { return pending.load() == 0; });
+		}
+	}
+	std::lock_guard<std::mutex> dm(done_mutex);
+}
+
+
+void MT::TaskGroup::wait() {
+	wait_all();
+
+	std::exception_ptr current_error;
+	{
+		std::lock_guard<std::mutex> em(error_mutex);
+		current_error = std::exchange(error, nullptr);
+	}
+	if (current_error) {
+		std::rethrow_exception(current_error);
+	}
+}
+
+
+bool MT::TaskGroup::is_done() const {
+	return pending.load() == 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <vector>
+#include "thread_pool.h"
+
+
+namespace MT {
+
+    // Группа задач, которую можно дождаться, не занимая поток пула впустую:
+    // пока задачи группы не выполнены, wait() из потока пула сам выполняет задачи из очередей
+    // в том же порядке, что и простаивающий поток (ThreadPool::take_job). Задачи группы, добавленные
+    // этим потоком, лежат в его деке и берутся раньше чужих, но задачи с приоритетом и задачи,
+    // оказавшиеся в общих очередях, могут выполниться первыми, в том числе задачи других групп.
+    // Когда работы нет, поток засыпает до появления новой задачи или завершения группы.
+    // Поэтому вложенный параллелизм не требует создания новых потоков
+    class TaskGroup : public MT::JobListener {
+        MT::ThreadPool& pool;
+
+        // число добавленных, но ещё не выполненных задач группы
+        std::atomic<size_t> pending;
+
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        // потоки пула, ждущие группу в ThreadPool::sleep_until_work
+        std::atomic<size_t> helpers;
+
+        // первое исключение, выброшенное задачей группы
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        // вызывается пулом после выполнения (или отклонения) задачи группы
+        void on_job_finished(std::exception_ptr job_error) override;
+
+        // ожидание без проброса исключения
+        void wait_all();
+
+     public:
+        explicit TaskGroup(MT::ThreadPool& pool_);
+
+        TaskGroup(const TaskGroup& other) = delete;
+        TaskGroup& operator=(const TaskGroup& other) = delete;
+
+        // добавление вызываемого объекта в группу
+        template <typename F>
+            requires std::is_invocable_v<std::decay_t<F>&>
+        size_t run(F&& f) {
+            pending.fetch_add(1);
+            return pool.push_job(MT::TaskFunction(std::forward<F>(f)), nullptr, this);
+        }
+
+
+        // добавление наследника Task, его результат попадает в хранилище результатов пула
+        template <typename TaskChild>
+            requires std::derived_from<TaskChild, MT::Task>
+        size_t run(std::shared_ptr<TaskChild> task) {
+            pending.fetch_add(1);
+            MT::Task* raw_task = task.get();
+            return pool.push_job(pool.wrap_task(std::move(task)), raw_task, this);
+        }
+
+
+        // пакетное добавление наследников Task, аналог ThreadPool::add_tasks
+        template <std::ranges::input_range Range>
+        std::pair<size_t, size_t> run_all(Range&& tasks) {
+            std::vector<std::shared_ptr<MT::Task>> batch;
+            for (auto&& task : tasks) {
+                batch.push_back(task);
+            }
+            pending.fetch_add(batch.size());
+            return pool.push_tasks(std::move(batch), this);
+        }
+
+
+        // ждёт выполнения всех задач группы и пробрасывает первое исключение из них
+        void wait();
+
+        bool is_done() const;
+
+        // дожидается задач группы, исключения при этом не пробрасываются
+        ~TaskGroup();
+    };
+}
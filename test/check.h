@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdlib>
+#include <iostream>
+
+
+// Проверка в тестах: в отличие от assert, не отключается в сборке с NDEBUG.
+// При неудаче печатает условие и завершает тест с ненулевым кодом для ctest
+#define MT_CHECK(condition)                                                                        \
+    do {                                                                                           \
+        if (!(condition)) {                                                                        \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " << #condition << '\n';  \
+            std::exit(1);                                                                          \
+        }                                                                                          \
+    } while (false)
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <ranges>
+#include <span>
+#include <vector>
+#include "../thread_pool.h"
+#include "../kway_merge.h"
+#include "check.h"
+
+
+// Слияние k серий: устойчивость LoserTree при k не степени двойки и пустых сериях,
+// разбиение partition_runs на множестве равных ключей и совпадение параллельного
+// слияния с последовательным
+
+namespace {
+    // ключ сравнения и происхождение элемента для проверки устойчивости
+    struct Item {
+        uint32_t key;
+        uint32_t run;
+        uint32_t index;
+    };
+
+
+    struct KeyLess {
+        bool operator()(const Item& a, const Item& b) const {
+            return a.key < b.key;
+        }
+    };
+
+
+    // при равных ключах раньше идёт элемент серии с меньшим номером, внутри серии - в исходном порядке
+    bool stable_before(const Item& a, const Item& b) {
+        if (a.key != b.key) {
+            return a.key < b.key;
+        }
+        return a.run != b.run ? a.run < b.run : a.index < b.index;
+    }
+
+
+    // серии со случайными ключами из [0, distinct); каждая empty_every-я серия пуста
+    std::vector<std::vector<Item>> make_runs(size_t k, size_t length, uint32_t distinct, size_t empty_every, std::mt19937& rng) {
+        std::vector<std::vector<Item>> runs(k);
+        for (size_t r : std::ranges::iota_view(size_t(0), k)) {
+            if (empty_every != 0 && r % empty_every == 0) {
+                continue;
+            }
+            size_t size = length / 2 + rng() % (length + 1);
+            for ([[maybe_unused]] size_t i : std::ranges::iota_view(size_t(0), size)) {
+                runs[r].push_back({static_cast<uint32_t>(rng() % distinct), static_cast<uint32_t>(r), 0});
+            }
+            std::ranges::stable_sort(runs[r], KeyLess());
+            for (size_t i : std::ranges::iota_view(size_t(0), runs[r].size())) {
+                runs[r][i].index = static_cast<uint32_t>(i);
+            }
+        }
+        return runs;
+    }
+
+
+    std::vector<std::span<const Item>> spans(const std::vector<std::vector<Item>>& runs) {
+        std::vector<std::span<const Item>> result;
+        for (const std::vector<Item>& run : runs) {
+            result.emplace_back(run);
+        }
+        return result;
+    }
+
+
+    std::vector<Item> expected_merge(const std::vector<std::vector<Item>>& runs) {
+        std::vector<Item> all;
+        for (const std::vector<Item>& run : runs) {
+            all.insert(all.end(), run.begin(), run.end());
+        }
+        std::ranges::sort(all, stable_before);
+        return all;
+    }
+
+
+    bool same(const std::vector<Item>& a, const std::vector<Item>& b) {
+        return std::ranges::equal(a, b, [](const Item& x, const Item& y) {
+            return x.key == y.key && x.run == y.run && x.index == y.index;
+        });
+    }
+
+
+    struct VectorOutput {
+        std::vector<Item>& items;
+
+        void write(const Item& item) {
+            items.push_back(item);
+        }
+    };
+
+
+    void loser_tree_stability() {
+        std::mt19937 rng(7);
+        for (size_t k : {1, 2, 3, 5, 6, 7, 13, 31}) {
+            for (size_t empty_every : {0, 1, 2, 3}) {
+                auto runs = make_runs(k, 40, 5, empty_every, rng);
+                std::vector<Item> merged;
+                VectorOutput output{merged};
+                MT::merge_runs(spans(runs), output, KeyLess());
+                MT_CHECK(same(merged, expected_merge(runs)));
+            }
+        }
+
+        // без серий дерево сразу пусто
+        MT::LoserTree<Item, KeyLess> none({});
+        MT_CHECK(none.empty());
+    }
+
+
+    // части не пересекаются по ключам, даже если почти все ключи равны
+    void partition_duplicates() {
+        std::mt19937 rng(11);
+        for (uint32_t distinct : {1u, 2u, 3u}) {
+            for (size_t parts : {2, 3, 8, 64}) {
+                auto runs = make_runs(7, 500, distinct, 3, rng);
+                auto run_spans = spans(runs);
+                auto bounds = MT::partition_runs(run_spans, parts, KeyLess());
+
+                MT_CHECK(bounds.size() >= 2 && bounds.size() - 1 <= parts);
+                for (size_t r : std::ranges::iota_view(size_t(0), runs.size())) {
+                    MT_CHECK(bounds.front()[r] == 0);
+                    MT_CHECK(bounds.back()[r] == runs[r].size());
+                    for (size_t j : std::ranges::iota_view(size_t(1), bounds.size())) {
+                        MT_CHECK(bounds[j - 1][r] <= bounds[j][r]);
+                    }
+                }
+
+                // каждый ключ части j строго меньше каждого ключа следующих частей
+                int64_t previous_max = -1;
+                size_t non_empty_parts = 0;
+                for (size_t j : std::ranges::iota_view(size_t(0), bounds.size() - 1)) {
+                    int64_t part_min = INT64_MAX;
+                    int64_t part_max = -1;
+                    for (size_t r : std::ranges::iota_view(size_t(0), runs.size())) {
+                        for (size_t i : std::ranges::iota_view(bounds[j][r], bounds[j + 1][r])) {
+                            part_min = std::min<int64_t>(part_min, runs[r][i].key);
+                            part_max = std::max<int64_t>(part_max, runs[r][i].key);
+                        }
+                    }
+                    if (part_max >= 0) {
+                        MT_CHECK(previous_max < part_min);
+                        previous_max = part_max;
+                        ++non_empty_parts;
+                    }
+                }
+                // равные ключи не делятся: непустых частей не больше, чем различных ключей
+                MT_CHECK(non_empty_parts >= 1 && non_empty_parts <= distinct);
+            }
+        }
+    }
+
+
+    // параллельное слияние по частям совпадает с устойчивым последовательным
+    void parallel_matches_sequential(MT::ThreadPool& pool) {
+        std::mt19937 rng(13);
+        for (uint32_t distinct : {1u, 4u, 1000u}) {
+            for (size_t parts : {0, 1, 3, 16}) {
+                auto runs = make_runs(9, 2000, distinct, 4, rng);
+                std::vector<Item> expected = expected_merge(runs);
+                std::vector<Item> merged(expected.size());
+
+                struct SliceOutput {
+                    std::vector<Item>& items;
+                    uint64_t position;
+
+                    void write(const Item& item) {
+                        items[position++] = item;
+                    }
+
+                    void close() {}
+                };
+                MT::parallel_merge_runs(pool, spans(runs), [&merged](uint64_t first) {
+                    return SliceOutput{merged, first};
+                }, KeyLess(), parts);
+                MT_CHECK(same(merged, expected));
+            }
+        }
+    }
+}
+
+
+int main() {
+    MT::PoolOptions options;
+    options.log_path = (std::filesystem::temp_directory_path() / "mt_test_kway_merge.log").string();
+    MT::ThreadPool pool(4, options);
+    pool.set_logger_flag(false);
+    pool.start();
+
+    loser_tree_stability();
+    partition_duplicates();
+    parallel_matches_sequential(pool);
+    std::cout << "test_kway_merge passed\n";
+    return 0;
+}
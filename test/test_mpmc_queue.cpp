@@ -0,0 +1,100 @@
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <ranges>
+#include <thread>
+#include <vector>
+#include "../mpmc_queue.h"
+#include "check.h"
+
+
+// Кольцо MPMC: границы "полно" и "пусто", в том числе после многих оборотов кольца,
+// и передача без потерь и повторов между несколькими производителями и потребителями
+
+namespace {
+    void full_and_empty() {
+        MT::BoundedMPMCQueue<int> queue(5);
+        MT_CHECK(queue.capacity() == 8);
+
+        int value = -1;
+        MT_CHECK(!queue.try_pop(value));
+        MT_CHECK(value == -1);
+
+        // несколько оборотов: номера последовательности ячеек должны оставаться согласованными
+        for (int lap : std::ranges::iota_view(0, 4)) {
+            for (int i : std::ranges::iota_view(0, 8)) {
+                MT_CHECK(queue.try_push(lap * 8 + i));
+            }
+            MT_CHECK(!queue.try_push(-1));
+            MT_CHECK(queue.size() == 8);
+
+            for (int i : std::ranges::iota_view(0, 8)) {
+                MT_CHECK(queue.try_pop(value));
+                MT_CHECK(value == lap * 8 + i);
+            }
+            MT_CHECK(!queue.try_pop(value));
+            MT_CHECK(queue.size() == 0);
+        }
+
+        // освободившаяся ячейка снова принимает элемент
+        for (int i : std::ranges::iota_view(0, 8)) {
+            MT_CHECK(queue.try_push(i));
+        }
+        MT_CHECK(queue.try_pop(value) && value == 0);
+        MT_CHECK(queue.try_push(8));
+        MT_CHECK(!queue.try_push(9));
+    }
+
+
+    // маленькое кольцо постоянно то заполнено, то пусто
+    void many_producers_many_consumers() {
+        constexpr size_t producers = 3;
+        constexpr size_t consumers = 3;
+        constexpr size_t per_producer = 50'000;
+        MT::BoundedMPMCQueue<size_t> queue(4);
+        std::vector<std::atomic<uint8_t>> seen(producers * per_producer);
+        std::atomic<size_t> received{0};
+
+        std::vector<std::thread> threads;
+        for (size_t producer : std::ranges::iota_view(size_t(0), producers)) {
+            threads.emplace_back([&, producer]() {
+                for (size_t i : std::ranges::iota_view(size_t(0), per_producer)) {
+                    while (!queue.try_push(producer * per_producer + i)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for ([[maybe_unused]] size_t consumer : std::ranges::iota_view(size_t(0), consumers)) {
+            threads.emplace_back([&]() {
+                size_t value = 0;
+                while (received.load() < seen.size()) {
+                    if (queue.try_pop(value)) {
+                        MT_CHECK(value < seen.size());
+                        MT_CHECK(seen[value].fetch_add(1) == 0);
+                        received.fetch_add(1);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        size_t value = 0;
+        MT_CHECK(!queue.try_pop(value));
+        for (const std::atomic<uint8_t>& count : seen) {
+            MT_CHECK(count.load() == 1);
+        }
+    }
+}
+
+
+int main() {
+    full_and_empty();
+    many_producers_many_consumers();
+    std::cout << "test_mpmc_queue passed\n";
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../thread_pool.h"
+#include "../pipeline.h"
+#include "check.h"
+
+
+// Pipeline: последовательные стадии видят токены строго в порядке порождения, даже если
+// параллельные стадии завершают их вразнобой; в обработке не больше max_tokens токенов;
+// исключение стадии или источника останавливает ввод и пробрасывается из run
+
+namespace {
+    // неравномерная работа, чтобы параллельная стадия завершала токены не по порядку
+    void uneven_work(size_t token) {
+        if (token % 7 == 0) {
+            std::this_thread::yield();
+        }
+        volatile size_t sink = 0;
+        for (size_t i = 0; i < (token * 37) % 500; ++i) {
+            sink = sink + i;
+        }
+    }
+
+
+    // источник чисел [0, count)
+    struct Counter {
+        size_t count;
+        size_t next = 0;
+
+        std::optional<size_t> operator()() {
+            if (next == count) {
+                return std::nullopt;
+            }
+            return next++;
+        }
+    };
+
+
+    void serial_order(MT::ThreadPool& pool) {
+        constexpr size_t count = 5000;
+        for (size_t tokens : {1, 2, 3, 16}) {
+            std::vector<size_t> first_serial;
+            std::vector<size_t> second_serial;
+            std::atomic<size_t> in_flight{0};
+            std::atomic<size_t> max_in_flight{0};
+
+            MT::Pipeline(pool, tokens).run(
+                [&, source = Counter{count}]() mutable -> std::optional<size_t> {
+                    std::optional<size_t> token = source();
+                    if (token) {
+                        size_t now = in_flight.fetch_add(1) + 1;
+                        size_t seen = max_in_flight.load();
+                        while (now > seen && !max_in_flight.compare_exchange_weak(seen, now)) {}
+                    }
+                    return token;
+                },
+                MT::parallel_stage([](size_t token) {
+                    uneven_work(token);
+                    return token;
+                }),
+                MT::serial_stage([&first_serial](size_t token) {
+                    first_serial.push_back(token);
+                    return std::to_string(token);
+                }),
+                MT::parallel_stage([](std::string token) {
+                    size_t value = std::stoul(token);
+                    uneven_work(value + 1);
+                    return value;
+                }),
+                MT::serial_stage([&](size_t token) {
+                    second_serial.push_back(token);
+                    in_flight.fetch_sub(1);
+                }));
+
+            MT_CHECK(first_serial.size() == count && second_serial.size() == count);
+            for (size_t i = 0; i < count; ++i) {
+                MT_CHECK(first_serial[i] == i && second_serial[i] == i);
+            }
+            MT_CHECK(in_flight.load() == 0);
+            MT_CHECK(max_in_flight.load() <= tokens);
+        }
+    }
+
+
+    void empty_source(MT::ThreadPool& pool) {
+        size_t calls = 0;
+        MT::Pipeline(pool, 4).run(Counter{0}, MT::serial_stage([&calls](size_t) { ++calls; }));
+        MT_CHECK(calls == 0);
+    }
+
+
+    // исключение стадии: ввод останавливается, токены в обработке доходят до конца, run бросает
+    void stage_exception(MT::ThreadPool& pool) {
+        constexpr size_t count = 100'000;
+        constexpr size_t failing = 100;
+        constexpr size_t tokens = 8;
+        size_t produced = 0;
+        std::vector<size_t> serial_seen;
+        std::string message;
+
+        try {
+            MT::Pipeline(pool, tokens).run(
+                [&produced, source = Counter{count}]() mutable {
+                    std::optional<size_t> token = source();
+                    produced += token.has_value();
+                    return token;
+                },
+                MT::parallel_stage([](size_t token) {
+                    if (token == failing) {
+                        throw std::runtime_error("stage failed at " + std::to_string(token));
+                    }
+                    return token;
+                }),
+                MT::serial_stage([&serial_seen](size_t token) { serial_seen.push_back(token); }));
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        MT_CHECK(message == "stage failed at 100");
+        // источник остановлен вскоре после ошибки, а не дочитан до конца
+        MT_CHECK(produced < failing + 2 * tokens + 1);
+        // после ошибки функции стадий не вызываются: последовательная стадия успела обработать
+        // начало входа по порядку и не дошла до ошибочного токена
+        MT_CHECK(serial_seen.size() <= failing);
+        for (size_t i = 0; i < serial_seen.size(); ++i) {
+            MT_CHECK(serial_seen[i] == i);
+        }
+    }
+
+
+    void source_exception(MT::ThreadPool& pool) {
+        std::vector<size_t> seen;
+        bool thrown = false;
+        try {
+            MT::Pipeline(pool, 4).run(
+                [source = Counter{1000}]() mutable -> std::optional<size_t> {
+                    std::optional<size_t> token = source();
+                    if (token == 10) {
+                        throw std::logic_error("source failed");
+                    }
+                    return token;
+                },
+                MT::serial_stage([&seen](size_t token) { seen.push_back(token); }));
+        } catch (const std::logic_error& e) {
+            thrown = std::string(e.what()) == "source failed";
+        }
+        MT_CHECK(thrown);
+        // токены, порождённые до ошибки, могут быть отброшены, но не переставлены
+        MT_CHECK(seen.size() <= 10);
+        for (size_t i = 0; i < seen.size(); ++i) {
+            MT_CHECK(seen[i] == i);
+        }
+    }
+
+
+    // конвейер, запущенный из задачи пула, не блокирует поток пула ожиданием
+    void run_inside_pool(MT::ThreadPool& pool) {
+        std::vector<size_t> seen;
+        auto future = pool.submit([&pool, &seen]() {
+            MT::Pipeline(pool, 4).run(Counter{1000},
+                                      MT::parallel_stage([](size_t token) { return token * 2; }),
+                                      MT::serial_stage([&seen](size_t token) { seen.push_back(token); }));
+        });
+        future.get();
+        MT_CHECK(seen.size() == 1000);
+        for (size_t i = 0; i < seen.size(); ++i) {
+            MT_CHECK(seen[i] == 2 * i);
+        }
+    }
+}
+
+
+int main() {
+    MT::PoolOptions options;
+    options.log_path = (std::filesystem::temp_directory_path() / "mt_test_pipeline.log").string();
+    MT::ThreadPool pool(4, options);
+    pool.set_logger_flag(false);
+    pool.start();
+
+    serial_order(pool);
+    empty_source(pool);
+    stage_exception(pool);
+    source_exception(pool);
+    run_inside_pool(pool);
+    std::cout << "test_pipeline passed\n";
+    return 0;
+}
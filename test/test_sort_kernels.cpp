@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+#include "../thread_pool.h"
+#include "../sort_kernels.h"
+#include "check.h"
+
+
+// Ядра без сравнений дают тот же результат, что std::sort: для всех целых типов, размеров
+// вокруг порогов переключения на std::sort и на параллельный вариант, и распределений,
+// на которых проходы поразрядной сортировки пропускаются или все ключи попадают в края диапазона
+
+namespace {
+    static_assert(MT::sort_kernel_for<int8_t>() == MT::SortKernel::counting);
+    static_assert(MT::sort_kernel_for<uint16_t>() == MT::SortKernel::counting);
+    static_assert(MT::sort_kernel_for<int32_t>() == MT::SortKernel::radix);
+    static_assert(MT::sort_kernel_for<uint64_t>() == MT::SortKernel::radix);
+    static_assert(MT::sort_kernel_for<bool>() == MT::SortKernel::comparison);
+    static_assert(MT::sort_kernel_for<double>() == MT::SortKernel::comparison);
+
+
+    enum class Distribution {
+        uniform,
+        few_distinct,
+        extremes,
+        sorted,
+        reversed,
+        equal
+    };
+
+
+    template <typename T>
+    std::vector<T> generate(size_t size, Distribution distribution, std::mt19937_64& rng) {
+        using Limits = std::numeric_limits<T>;
+        std::vector<T> values(size);
+        for (T& value : values) {
+            uint64_t bits = rng();
+            switch (distribution) {
+                case Distribution::few_distinct:
+                    value = static_cast<T>(bits % 3);
+                    break;
+                case Distribution::extremes:
+                    value = bits % 2 == 0 ? Limits::min() : Limits::max();
+                    break;
+                case Distribution::equal:
+                    value = static_cast<T>(-1);
+                    break;
+                default:
+                    value = static_cast<T>(bits);
+            }
+        }
+        if (distribution == Distribution::sorted) {
+            std::sort(values.begin(), values.end());
+        } else if (distribution == Distribution::reversed) {
+            std::sort(values.begin(), values.end(), std::greater<>());
+        }
+        return values;
+    }
+
+
+    template <typename T>
+    void check_type(MT::ThreadPool& pool, std::mt19937_64& rng) {
+        // пустой и одиночный массивы, границы последовательного порога и порога параллельного ядра
+        const size_t sizes[] = {0, 1, 2, 127, 128, 129, 4095, 4096, 4097, (1 << 16) + 1, 200'000};
+        const Distribution distributions[] = {Distribution::uniform, Distribution::few_distinct, Distribution::extremes,
+                                              Distribution::sorted, Distribution::reversed, Distribution::equal};
+        for (size_t size : sizes) {
+            for (Distribution distribution : distributions) {
+                std::vector<T> expected = generate<T>(size, distribution, rng);
+                std::vector<T> sequential = expected;
+                std::vector<T> parallel = expected;
+                std::sort(expected.begin(), expected.end());
+
+                MT::sort_kernel(std::span<T>(sequential));
+                MT_CHECK(sequential == expected);
+
+                MT::parallel_sort_kernel(pool, std::span<T>(parallel));
+                MT_CHECK(parallel == expected);
+            }
+        }
+    }
+}
+
+
+int main() {
+    MT::PoolOptions options;
+    options.log_path = (std::filesystem::temp_directory_path() / "mt_test_sort_kernels.log").string();
+    MT::ThreadPool pool(4, options);
+    pool.set_logger_flag(false);
+    pool.start();
+
+    std::mt19937_64 rng(3);
+    check_type<int8_t>(pool, rng);
+    check_type<uint8_t>(pool, rng);
+    check_type<char>(pool, rng);
+    check_type<int16_t>(pool, rng);
+    check_type<uint16_t>(pool, rng);
+    check_type<int32_t>(pool, rng);
+    check_type<uint32_t>(pool, rng);
+    check_type<int64_t>(pool, rng);
+    check_type<uint64_t>(pool, rng);
+    std::cout << "test_sort_kernels passed\n";
+    return 0;
+}
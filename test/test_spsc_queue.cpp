@@ -0,0 +1,113 @@
+#include <iostream>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../spsc_queue.h"
+#include "check.h"
+
+
+// SPSC очередь буферов Logger и EventDispatcher: границы "полно" и "пусто", порядок элементов
+// между потоками и освобождение очередей завершившихся производителей в PerThreadQueues
+
+namespace {
+    void full_and_empty() {
+        MT::SpscQueue<std::string> queue(3);
+        MT_CHECK(queue.capacity() == 4);
+        MT_CHECK(queue.empty());
+
+        std::string value;
+        MT_CHECK(!queue.try_pop(value));
+
+        for (int lap : std::ranges::iota_view(0, 3)) {
+            for (int i : std::ranges::iota_view(0, 4)) {
+                MT_CHECK(queue.try_push(std::to_string(lap * 4 + i)));
+            }
+            // отказ не должен забирать элемент у вызывающего
+            std::string rejected = "rejected";
+            MT_CHECK(!queue.try_push(std::move(rejected)));
+            MT_CHECK(rejected == "rejected");
+            MT_CHECK(!queue.empty());
+
+            for (int i : std::ranges::iota_view(0, 4)) {
+                MT_CHECK(queue.try_pop(value));
+                MT_CHECK(value == std::to_string(lap * 4 + i));
+            }
+            MT_CHECK(!queue.try_pop(value));
+            MT_CHECK(queue.empty());
+        }
+    }
+
+
+    // элементы приходят в порядке добавления, хотя очередь постоянно переполняется
+    void producer_consumer_order() {
+        constexpr size_t items = 200'000;
+        MT::SpscQueue<size_t> queue(8);
+
+        std::thread producer([&queue]() {
+            for (size_t i : std::ranges::iota_view(size_t(0), items)) {
+                while (!queue.try_push(size_t(i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        size_t expected = 0;
+        size_t value = 0;
+        while (expected < items) {
+            if (queue.try_pop(value)) {
+                MT_CHECK(value == expected);
+                ++expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        MT_CHECK(!queue.try_pop(value));
+    }
+
+
+    // очередь завершившегося потока освобождается, как только из неё всё разобрано
+    void per_thread_queues() {
+        constexpr size_t producers = 3;
+        constexpr size_t per_producer = 16;
+        MT::PerThreadQueues<size_t> queues(per_producer);
+
+        std::vector<std::thread> threads;
+        for (size_t producer : std::ranges::iota_view(size_t(0), producers)) {
+            threads.emplace_back([&queues, producer]() {
+                MT::SpscQueue<size_t>& local = queues.local();
+                for (size_t i : std::ranges::iota_view(size_t(0), per_producer)) {
+                    MT_CHECK(local.try_push(producer * per_producer + i));
+                }
+                MT_CHECK(&queues.local() == &local);
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        MT_CHECK(queues.queue_count() == producers);
+
+        std::vector<size_t> last(producers, 0);
+        std::vector<size_t> counts(producers, 0);
+        size_t drained = queues.drain([&](size_t value) {
+            size_t producer = value / per_producer;
+            MT_CHECK(producer < producers);
+            // внутри одного потока порядок сохраняется
+            MT_CHECK(counts[producer] == 0 || value > last[producer]);
+            last[producer] = value;
+            ++counts[producer];
+        });
+        MT_CHECK(drained == producers * per_producer);
+        MT_CHECK(queues.queue_count() == 0);
+    }
+}
+
+
+int main() {
+    full_and_empty();
+    producer_consumer_order();
+    per_thread_queues();
+    std::cout << "test_spsc_queue passed\n";
+    return 0;
+}
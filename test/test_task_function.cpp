@@ -0,0 +1,171 @@
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <utility>
+#include "../task_function.h"
+#include "check.h"
+
+
+// TaskFunction: маленькие объекты хранятся без выделения памяти, большие, сверхвыровненные
+// и с бросающим перемещением - в куче; каждый хранимый объект разрушается ровно один раз
+
+namespace {
+    std::atomic<size_t> allocations{0};
+
+    // счётчик живых объектов
+    struct Tracked {
+        static inline int alive = 0;
+        int* calls;
+
+        explicit Tracked(int* calls_) : calls(calls_) {
+            ++alive;
+        }
+
+        Tracked(const Tracked& other) : calls(other.calls) {
+            ++alive;
+        }
+
+        Tracked(Tracked&& other) noexcept : calls(other.calls) {
+            ++alive;
+        }
+
+        ~Tracked() {
+            --alive;
+        }
+
+        void operator()() {
+            ++*calls;
+        }
+    };
+
+
+    struct ThrowingMove {
+        int* calls;
+
+        explicit ThrowingMove(int* calls_) : calls(calls_) {}
+
+        ThrowingMove(ThrowingMove&& other) noexcept(false) : calls(other.calls) {}
+
+        void operator()() {
+            ++*calls;
+        }
+    };
+
+
+    struct alignas(2 * alignof(std::max_align_t)) OverAligned {
+        int* calls;
+
+        void operator()() {
+            ++*calls;
+        }
+    };
+
+
+    template <typename F>
+    size_t allocations_to_wrap(F f) {
+        size_t before = allocations.load();
+        MT::TaskFunction function(std::move(f));
+        size_t after = allocations.load();
+        function();
+        return after - before;
+    }
+
+
+    void storage_choice() {
+        int calls = 0;
+        MT_CHECK(allocations_to_wrap([&calls]() { ++calls; }) == 0);
+        MT_CHECK(allocations_to_wrap(Tracked(&calls)) == 0);
+
+        std::array<char, MT::TaskFunction::inline_size> big{};
+        MT_CHECK(allocations_to_wrap([&calls, big]() { calls += big[0] + 1; }) == 1);
+        MT_CHECK(allocations_to_wrap(ThrowingMove(&calls)) == 1);
+        MT_CHECK(allocations_to_wrap(OverAligned{&calls}) == 1);
+        MT_CHECK(calls == 5);
+    }
+
+
+    void move_only_and_lifetime() {
+        int calls = 0;
+        {
+            MT::TaskFunction first{Tracked(&calls)};
+            MT_CHECK(Tracked::alive == 1);
+
+            MT::TaskFunction second(std::move(first));
+            MT_CHECK(!first && second);
+            MT_CHECK(Tracked::alive == 1);
+            second();
+
+            MT::TaskFunction third;
+            MT_CHECK(!third);
+            third = std::move(second);
+            third();
+            MT_CHECK(Tracked::alive == 1);
+
+            // присваивание разрушает прежний объект
+            third = MT::TaskFunction(Tracked(&calls));
+            MT_CHECK(Tracked::alive == 1);
+            third.reset();
+            MT_CHECK(!third && Tracked::alive == 0);
+        }
+        MT_CHECK(Tracked::alive == 0);
+        MT_CHECK(calls == 2);
+
+        // захват только перемещаемого объекта
+        std::unique_ptr<int> owned = std::make_unique<int>(41);
+        MT::TaskFunction increment([owned = std::move(owned)]() { ++*owned; });
+        MT::TaskFunction moved(std::move(increment));
+        moved();
+    }
+}
+
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc требует размер, кратный выравниванию
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+
+int main() {
+    storage_choice();
+    move_only_and_lifetime();
+    std::cout << "test_task_function passed\n";
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../thread_pool.h"
+#include "../task_graph.h"
+#include "../task_group.h"
+#include "check.h"
+
+
+// TaskGraph: узел запускается только после всех предшественников, ошибка узла отменяет
+// зависящие от него узлы и пробрасывается из wait(), граф можно запускать повторно,
+// в том числе из задачи пула
+
+namespace {
+    // ромб a -> (b, c) -> d плюс независимая цепочка e -> f; каждый узел записывает свой номер
+    struct Diamond {
+        MT::TaskGraph graph;
+        std::mutex order_mutex;
+        std::vector<size_t> order;
+
+        Diamond() {
+            std::vector<MT::TaskGraph::NodeId> ids;
+            for (size_t i : std::ranges::iota_view(size_t(0), size_t(6))) {
+                ids.push_back(graph.add([this, i]() {
+                    std::lock_guard<std::mutex> om(order_mutex);
+                    order.push_back(i);
+                }));
+            }
+            graph.precede(ids[0], ids[1]);
+            graph.precede(ids[0], ids[2]);
+            graph.precede(ids[1], ids[3]);
+            graph.precede(ids[2], ids[3]);
+            graph.precede(ids[4], ids[5]);
+        }
+
+        size_t position(size_t node) const {
+            return static_cast<size_t>(std::ranges::find(order, node) - order.begin());
+        }
+
+        void check_order() const {
+            MT_CHECK(order.size() == 6);
+            MT_CHECK(position(0) < position(1) && position(0) < position(2));
+            MT_CHECK(position(1) < position(3) && position(2) < position(3));
+            MT_CHECK(position(4) < position(5));
+        }
+    };
+
+
+    void dependencies_and_reuse(MT::ThreadPool& pool) {
+        Diamond diamond;
+        for ([[maybe_unused]] size_t run : std::ranges::iota_view(size_t(0), size_t(50))) {
+            diamond.order.clear();
+            pool.run_graph(diamond.graph);
+            diamond.graph.wait();
+            MT_CHECK(diamond.graph.is_done());
+            diamond.check_order();
+        }
+    }
+
+
+    void failure_cancels_successors(MT::ThreadPool& pool) {
+        MT::TaskGraph graph;
+        std::atomic<size_t> ran{0};
+        auto failing = graph.add([]() { throw std::runtime_error("node failed"); });
+        auto after = graph.add([&ran]() { ran.fetch_add(1); });
+        auto transitive = graph.add([&ran]() { ran.fetch_add(1); });
+        [[maybe_unused]] auto independent = graph.add([&ran]() { ran.fetch_add(10); });
+        graph.precede(failing, after);
+        graph.precede(after, transitive);
+
+        pool.run_graph(graph);
+        bool thrown = false;
+        try {
+            graph.wait();
+        } catch (const std::runtime_error& e) {
+            thrown = std::string(e.what()) == "node failed";
+        }
+        MT_CHECK(thrown);
+        MT_CHECK(ran.load() == 10);
+
+        // ошибка не переносится на следующий запуск
+        pool.run_graph(graph);
+        try {
+            graph.wait();
+        } catch (const std::runtime_error&) {
+            thrown = false;
+        }
+        MT_CHECK(!thrown);
+    }
+
+
+    void cycle_is_rejected(MT::ThreadPool& pool) {
+        MT::TaskGraph graph;
+        auto a = graph.add([]() {});
+        auto b = graph.add([]() {});
+        graph.precede(a, b);
+        graph.precede(b, a);
+        bool thrown = false;
+        try {
+            pool.run_graph(graph);
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        MT_CHECK(thrown);
+    }
+
+
+    // граф, ожидаемый из задач пула: ждущий поток выполняет узлы сам или спит до их завершения
+    void wait_inside_pool(MT::ThreadPool& pool) {
+        std::atomic<size_t> completed{0};
+        MT::TaskGroup group(pool);
+        for ([[maybe_unused]] size_t task : std::ranges::iota_view(size_t(0), size_t(8))) {
+            group.run([&pool, &completed]() {
+                Diamond diamond;
+                pool.run_graph(diamond.graph);
+                diamond.graph.wait();
+                diamond.check_order();
+                completed.fetch_add(1);
+            });
+        }
+        group.wait();
+        MT_CHECK(completed.load() == 8);
+    }
+}
+
+
+int main() {
+    MT::PoolOptions options;
+    options.log_path = (std::filesystem::temp_directory_path() / "mt_test_task_graph.log").string();
+    MT::ThreadPool pool(4, options);
+    pool.set_logger_flag(false);
+    pool.start();
+
+    dependencies_and_reuse(pool);
+    failure_cancels_successors(pool);
+    cycle_is_rejected(pool);
+    wait_inside_pool(pool);
+    std::cout << "test_task_graph passed\n";
+    return 0;
+}
@@ -7,12 +7,17 @@
 #include <map>
 #include <filesystem>
 #include "../thread_pool.h"
+#include "../task_group.h"
+#include "../sort_kernels.h"
+#include "../run_file.h"
+#include "../external_sort.h"
+#include "../substring_search.h"
 
 
 
 // Тип задачи
 enum class TaskType {
-	ComputePrimes, SortRandom, WaitEcho, SortBigVec, SearchInALargeFile
+	ComputePrimes, SortRandom, WaitEcho, SortBigVec, SearchInALargeFile, SearchWordsInALargeFile
 };
 
 
@@ -25,6 +30,8 @@ struct SortRandom : public MT::Task {
 
     void one_thread_method() override;
     void show_result() override;
+    std::string describe() const override;
+    size_t memory_footprint() const override;
 };
 
 
@@ -38,6 +45,8 @@ struct ComputePrimes : public MT::Task {
 
     void one_thread_method() override;
     void show_result() override;
+    std::string describe() const override;
+    size_t memory_footprint() const override;
 };
 
 
@@ -45,76 +54,56 @@ struct ComputePrimes : public MT::Task {
 // блокируем поток на заданное кол-во секунд
 struct WaitEcho : public MT::Task {
     size_t seconds;
+    std::string message;
 
     WaitEcho(size_t seconds_, const std::string message_);
 
     void one_thread_method() override;
     void show_result() override;
+    std::string describe() const override;
 };
 
 
 
-class SortingChunk;
-
-// Сотрировка элементов файла, при этом многопоточная
+// Сотрировка элементов файла, при этом многопоточная: внешняя сортировка MT::ExternalSorter
+// с бюджетом памяти memory_budget. Вход и результат хранятся в двоичном формате серий
+// (run_file.h), в текст результат переводится только в show_result
 class SortBigVec : public MT::Task {
-    std::mutex temp_files_mutex;
-    std::condition_variable chunks_cv;
-    std::atomic<size_t> completed_chunks{0};
-
     std::string file_name;
     std::filesystem::path dir_name;
 
-    std::vector<std::string> temp_files;
-    const size_t chunk_size = 1'000'000;
+    // 8 МиБ - серии по миллиону 16-битных элементов
+    const size_t memory_budget = size_t(8) << 20;
     size_t file_id;
     size_t n;
 
-    friend class SortingChunk;
+    std::string result_name() const;
 
  public:
 
     SortBigVec(size_t n_ = 1'000'000u);
 
-    std::vector<int16_t> read_chunk(size_t chunk_size, std::ifstream& file);
-    void merge_sorted_chunks();
     void one_thread_method() override;
     void show_result() override;
+    std::string describe() const override;
 
     ~SortBigVec();
 };
 
 
-class SortingChunk : public MT::Task {
-    std::vector<int16_t> arr; 
-    SortBigVec& parrent;
-
- public:
-    SortingChunk(std::vector<int16_t>& arr_, SortBigVec& parrent_);
-
-    void one_thread_method() override;
-    void show_result() override;
-};
 
 
 
 
-
-
-class SearchInAChunk;
-
+// Поиск слова в файле: файл отображается в память, части по MT::search_chunk_bytes
+// просматриваются SIMD-поиском (substring_search.h) на потоках пула
 class SearchInALargeFile : public MT::Task {
+    // номер строки -> строка и число вхождений в неё
     std::map<size_t, std::pair<std::string, size_t>> information_found;
     std::string path_to_file;
     std::string word;
 
     std::mutex information_found_mutex;
-    std::condition_variable information_cv;
-    std::atomic<size_t> completed_chunks{0};
-
-    size_t chunk_size = 100;
-
-    friend class SearchInAChunk;
 
  public:
 
@@ -122,18 +111,24 @@ class SearchInALargeFile : public MT::Task {
 
     void one_thread_method() override;
     void show_result() override;
-
+    std::string describe() const override;
 };
 
 
-class SearchInAChunk : public MT::Task {
-    SearchInALargeFile& parrent;
-    std::vector<std::pair<size_t, std::string>> chunc;
+// Поиск нескольких слов за один проход по файлу автоматом Ахо-Корасик (MT::MultiPatternSearcher):
+// время просмотра не зависит от числа слов
+class SearchWordsInALargeFile : public MT::Task {
+    // для каждого слова - число вхождений и номера строк с вхождениями
+    std::vector<size_t> counts;
+    std::vector<std::vector<size_t>> lines;
+    std::string path_to_file;
+    std::vector<std::string> words;
 
  public:
 
-    SearchInAChunk(SearchInALargeFile& parrent_, std::vector<std::pair<size_t, std::string>>&& chunc);
+    SearchWordsInALargeFile(const std::string& path_to_file_, std::vector<std::string> words_);
 
     void one_thread_method() override;
     void show_result() override;
+    std::string describe() const override;
 };
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <ranges>
+#include <thread>
+#include <vector>
+#include "../work_stealing_deque.h"
+#include "check.h"
+
+
+// Дек Chase-Lev: каждый элемент достаётся ровно одному потоку - владельцу (pop) или вору (steal),
+// в том числе при гонке за последний элемент и при росте буфера во время кражи
+
+namespace {
+    void owner_order() {
+        MT::WorkStealingDeque<int> deque(2);
+        MT_CHECK(!deque.pop() && !deque.steal());
+        for (int i : std::ranges::iota_view(0, 10)) {
+            deque.push(i);
+        }
+        MT_CHECK(deque.size() == 10);
+        // владелец забирает с конца, вор - с начала
+        MT_CHECK(deque.pop() == 9);
+        MT_CHECK(deque.steal() == 0);
+        MT_CHECK(deque.pop() == 8);
+        MT_CHECK(deque.steal() == 1);
+        MT_CHECK(deque.size() == 6);
+    }
+
+
+    // владелец кладёт и забирает элементы, воры крадут; каждый элемент должен быть получен один раз
+    void pop_steal_race() {
+        constexpr size_t items = 200'000;
+        constexpr size_t thieves = 3;
+        MT::WorkStealingDeque<size_t> deque(4);
+        std::vector<std::atomic<uint8_t>> seen(items);
+        std::atomic<bool> done{false};
+
+        auto take = [&seen](size_t item) {
+            MT_CHECK(item < items);
+            MT_CHECK(seen[item].fetch_add(1) == 0);
+        };
+
+        std::vector<std::thread> threads;
+        for ([[maybe_unused]] size_t thief : std::ranges::iota_view(size_t(0), thieves)) {
+            threads.emplace_back([&]() {
+                while (!done.load()) {
+                    if (std::optional<size_t> item = deque.steal()) {
+                        take(*item);
+                    }
+                }
+                while (std::optional<size_t> item = deque.steal()) {
+                    take(*item);
+                }
+            });
+        }
+
+        for (size_t item : std::ranges::iota_view(size_t(0), items)) {
+            deque.push(item);
+            // через раз забираем сами, часто - последний элемент дека, за который соревнуются воры
+            if (item % 2 == 1) {
+                if (std::optional<size_t> own = deque.pop()) {
+                    take(*own);
+                }
+            }
+        }
+        while (std::optional<size_t> own = deque.pop()) {
+            take(*own);
+        }
+        done.store(true);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        for (const std::atomic<uint8_t>& count : seen) {
+            MT_CHECK(count.load() == 1);
+        }
+    }
+
+
+    // один элемент в деке: его получает либо владелец, либо ровно один вор
+    void last_item_race() {
+        constexpr size_t rounds = 20'000;
+        MT::WorkStealingDeque<size_t> deque;
+        std::atomic<size_t> stolen{0};
+        std::atomic<bool> done{false};
+
+        std::thread thief([&]() {
+            while (!done.load()) {
+                if (deque.steal()) {
+                    stolen.fetch_add(1);
+                }
+            }
+        });
+
+        size_t popped = 0;
+        for (size_t r : std::ranges::iota_view(size_t(0), rounds)) {
+            deque.push(r);
+            if (deque.pop()) {
+                ++popped;
+            }
+            // дек должен опустеть до следующего раунда
+            while (!deque.empty()) {}
+        }
+        done.store(true);
+        thief.join();
+
+        MT_CHECK(popped + stolen.load() == rounds);
+        MT_CHECK(!deque.pop() && !deque.steal());
+    }
+}
+
+
+int main() {
+    owner_order();
+    pop_steal_race();
+    last_item_race();
+    std::cout << "test_work_stealing_deque passed\n";
+    return 0;
+}
@@ -1,10 +1,49 @@
 #include "thread_pool.h"
+#include "task_graph.h"
+#include <algorithm>
 
 
-MT::Task::Task(const std::string& description_) {
-    description = description_;
+namespace {
+	// поток пула, исполняющий текущий код, и пул, которому он принадлежит
+	thread_local MT::Thread* current_thread = nullptr;
+	thread_local MT::ThreadPool* current_pool = nullptr;
+}
+
+
+MT::Task::Task() {
+    static_description = nullptr;
+    task_id = 0;
     status = MT::Task::TaskStatus::awating;
     thread_pool = nullptr;
+    node_hint = MT::any_node;
+}
+
+
+MT::Task::Task(const char* description_) : Task() {
+    static_description = description_;
+}
+
+
+MT::Task::Task(const std::string& description_) : Task() {
+    description = description_;
+}
+
+
+size_t MT::Task::memory_footprint() const {
+	return sizeof(MT::Task) + description.capacity();
+}
+
+
+void MT::Task::prefer_node(size_t node) {
+	node_hint = node;
+}
+
+
+std::string MT::Task::describe() const {
+	if (static_description != nullptr) {
+		return static_description;
+	}
+	return description;
 }
 
 
@@ -15,63 +54,270 @@ void MT::Task::one_thread_pre_method() {
 }
 
 
-MT::ThreadPool::ThreadPool(size_t NUM_THREADS) : logger(logger_mutex), controller(*this) {
+MT::ThreadPool::ThreadPool(size_t NUM_THREADS, const MT::PoolOptions& options_) : 
+		options(options_), completed_tasks(options_.result_retention),
+		logger(options_.log_path, options_.log_overflow_policy) {
 	paused.store(true);
     stopped.store(false);
     logger_flag.store(true);
 	completed_task_count = 0;
+	failed_task_count = 0;
     last_task_id = 0;
-	threads.reserve(max_threads);
-
-	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), NUM_THREADS)) {
-		try {
-			threads.emplace_back();
-		} catch (const std::system_error& e) {
-			std::string error_code_str = std::to_string(e.code().value()); 
-			std::string error = std::string("When creating thread caught system_error with code ") + "[" + error_code_str + "] meaning " + "[" + e.what() + "]";
-			std::time_t error_time = std::time(nullptr);
-			
-			{
-				std::lock_guard<std::mutex> cm(cout_mutex);
-				std::cerr << error << '\n';
+	queued_tasks = 0;
+	sleeping_threads = 0;
+	actual_threads_count = 0;
+	live_threads = 0;
+	threads_started = 0;
+	threads_retired = 0;
+	external_lock_contentions = 0;
+	blocked_producers = 0;
+	if (options.queue_type == MT::QueueType::bounded_ring) {
+		ring_queue = std::make_unique<MT::BoundedMPMCQueue<MT::Job*>>(options.ring_capacity);
+	}
+
+	if (options.max_threads == 0) {
+		min_threads = NUM_THREADS;
+		max_threads = NUM_THREADS;
+	} else {
+		if (options.min_threads > options.max_threads) {
+			throw std::invalid_argument("PoolOptions::min_threads exceeds PoolOptions::max_threads");
+		}
+		min_threads = options.min_threads;
+		max_threads = options.max_threads;
+	}
+
+	threads = std::make_unique<MT::Thread[]>(max_threads);
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), max_threads)) {
+		threads[i].index = i;
+	}
+
+	if (options.placement != MT::ThreadPlacement::none) {
+		MT::CpuTopology topology = options.topology.empty() ? MT::CpuTopology::detect() : options.topology;
+		if (std::ranges::any_of(topology.nodes, [](const std::vector<size_t>& cpus) { return cpus.empty(); })) {
+			throw std::invalid_argument("PoolOptions::topology has a node without CPUs");
+		}
+		size_t nodes_count = topology.nodes.size();
+		bool numa = options.placement == MT::ThreadPlacement::numa_nodes;
+
+		// соседние ячейки попадают на разные узлы, чтобы небольшой пул занимал все узлы
+		for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), max_threads)) {
+			size_t node = i % nodes_count;
+			const std::vector<size_t>& cpus = topology.nodes[node];
+			threads[i].cpu = static_cast<int>(cpus[(i / nodes_count) % cpus.size()]);
+			threads[i].node = numa ? node : 0;
+		}
+
+		if (numa) {
+			for (size_t node : std::ranges::iota_view(static_cast<size_t>(0), nodes_count)) {
+				node_queues.push_back(std::make_unique<SharedJobQueue>());
+				for (size_t cpu : topology.nodes[node]) {
+					if (cpu >= cpu_nodes.size()) {
+						cpu_nodes.resize(cpu + 1, 0);
+					}
+					cpu_nodes[cpu] = node;
+				}
+			}
+		}
+	}
+
+	// контроллер создаётся до потоков: они читают controller без синхронизации.
+	// Пока в пул не добавлена ни одна задача, контроллер только ждёт
+	if (min_threads != max_threads) {
+		controller = std::make_unique<MT::ThreadPoolController>(*this);
+	}
+
+	size_t initial_threads = std::clamp(NUM_THREADS, min_threads, max_threads);
+	try {
+		for ([[maybe_unused]] size_t i : std::ranges::iota_view(static_cast<size_t>(0), initial_threads)) {
+			add_worker();
+		}
+	} catch (const std::system_error& e) {
+		// деструктор не будет вызван - уже запущенные потоки останавливаем здесь
+		stopped.store(true);
+		{
+			std::lock_guard<std::mutex> sl(sleep_mutex);
+		}
+		tasks_access.notify_all();
+		for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), actual_threads_count.load())) {
+			if (threads[i]._thread.joinable()) {
+				threads[i]._thread.join();
 			}
-			std::lock_guard<std::mutex> lm(logger_mutex);
-			logger.log_error(error_time, error);
-			actual_threads_count = i;
-			throw;
 		}
+		throw;
+	}
+}
+
+
+bool MT::ThreadPool::add_worker() {
+	// ячейка освобождается потоком в самом конце run, поэтому при live_threads < max_threads
+	// свободной ячейки может на короткое время не оказаться
+	MT::Thread* slot = nullptr;
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), max_threads)) {
+		if (!threads[i].is_alive.load()) {
+			slot = &threads[i];
+			break;
+		}
+	}
+	if (slot == nullptr) {
+		return false;
+	}
+
+	if (slot->_thread.joinable()) {
+		// прежний поток ячейки уже вышел из run
+		slot->_thread.join();
+	}
+	slot->high_streak = 0;
+	slot->is_working.store(false);
+	if (!slot->latency) {
+		// ячейка занимается впервые; читатели видят указатель после увеличения actual_threads_count
+		slot->latency = std::make_unique<MT::LatencyRecorder>();
 	}
-	
-	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), NUM_THREADS)) {
-		threads[i]._thread = std::move(std::thread(&ThreadPool::run, this, std::ref(threads[i])));
-		threads[i].is_working.store(false);
-		threads[i].is_waiting.store(false);
+	slot->is_alive.store(true);
+	live_threads.fetch_add(1);
+	if (slot->index >= actual_threads_count.load()) {
+		actual_threads_count.store(slot->index + 1);
+	}
+
+	try {
+		slot->_thread = std::thread(&ThreadPool::run, this, std::ref(*slot));
+	} catch (const std::system_error& e) {
+		slot->is_alive.store(false);
+		live_threads.fetch_sub(1);
+
+		std::string error_code_str = std::to_string(e.code().value()); 
+		std::string error = std::string("When creating thread caught system_error with code ") + "[" + error_code_str + "] meaning " + "[" + e.what() + "]";
+		logger.log_error(std::time(nullptr), error);
+		events.publish(MT::TaskEventType::pool_error, 0, std::move(error));
+		throw;
+	}
+	threads_started.fetch_add(1);
+	return true;
+}
+
+
+bool MT::ThreadPool::retire_worker() {
+	size_t live = live_threads.load();
+	while (live > min_threads) {
+		if (live_threads.compare_exchange_weak(live, live - 1)) {
+			threads_retired.fetch_add(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool MT::ThreadPool::is_overloaded() const {
+	return queued_count() != 0 && sleeping_threads.load() == 0 && !paused.load()
+		   && live_threads.load() < max_threads;
+}
+
+
+size_t MT::ThreadPool::dequeued_count() const {
+	// id выдаются при добавлении, поэтому всё, что добавлено и уже не в очереди, из неё вышло;
+	// очередь читается раньше id, поэтому разность не отрицательна
+	size_t queued = queued_count();
+	size_t submitted = last_task_id.load();
+	return submitted > queued ? submitted - queued : 0;
+}
+
+
+size_t MT::ThreadPool::queued_count() const {
+	// задача покидает очередь раньше, чем завершается, поэтому в очереди не больше невыполненных
+	size_t queued = queued_tasks.load();
+	size_t finished = completed_task_count.load() + failed_task_count.load();
+	size_t submitted = last_task_id.load();
+	return std::min(queued, submitted > finished ? submitted - finished : 0);
+}
+
+
+MT::ThreadPoolController::ThreadPoolController(MT::ThreadPool& pool_ref) : pool(pool_ref), stopped(false), pressure(false) {
+	controller_thread = std::thread(&ThreadPoolController::monitor, this);
+}
+
+
+MT::ThreadPoolController::~ThreadPoolController() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	wakeup.notify_one();
+	if (controller_thread.joinable()) {
+		controller_thread.join();
+	}
+}
+
+
+void MT::ThreadPoolController::notify() {
+	// при постоянной нагрузке флаг уже поднят, и добавление задачи обходится одним чтением
+	if (!pressure.load(std::memory_order_relaxed) && !pressure.exchange(true)) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		wakeup.notify_one();
+	}
+}
+
+
+void MT::ThreadPoolController::monitor() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wakeup.wait(lock, [this]() -> bool { return stopped || pressure.load(); });
+		if (stopped) {
+			break;
+		}
+		// флаг сбрасывается до проверки: сигнал, пришедший во время проверки, не потеряется
+		pressure.store(false);
+
+		size_t dequeued = pool.dequeued_count();
+		size_t queued = 0;
+		while (!stopped && pool.is_overloaded()) {
+			// задачи, стоявшие в очереди при прошлой проверке, не успели её покинуть за grow_after -
+			// значит, самая старая задача ждёт дольше grow_after
+			// задача учитывается в id раньше, чем в очереди, поэтому dequeued_count может на время уменьшиться
+			size_t dequeued_now = pool.dequeued_count();
+			size_t left = dequeued_now > dequeued ? dequeued_now - dequeued : 0;
+			bool stalled = left < queued;
+			bool deep = pool.queued_count() > pool.options.grow_queue_depth * pool.live_threads.load();
+			if (stalled || deep) {
+				lock.unlock();
+				try {
+					pool.add_worker();
+				} catch (const std::system_error&) {
+					// ошибка уже записана в журнал, пул продолжает работу с текущими потоками
+				}
+				lock.lock();
+			}
+
+			dequeued = dequeued_now;
+			queued = pool.queued_count();
+			wakeup.wait_for(lock, pool.options.grow_after, [this]() -> bool { return stopped; });
+		}
 	}
-	actual_threads_count = NUM_THREADS;
 }
 
 
 MT::ThreadPool::~ThreadPool() {
 	wait();
+	// контроллер останавливается первым, чтобы не запускал новые потоки
+	controller.reset();
 	stopped.store(true);
+	{
+		std::lock_guard<std::mutex> sl(sleep_mutex);
+	}
 	tasks_access.notify_all();
 	clear_completed();
-	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), actual_threads_count)) {
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), actual_threads_count.load())) {
         if (threads[i]._thread.joinable()) {
 		    try {
                 threads[i]._thread.join();
             } catch (const std::system_error& e) {
 				std::string error_code_str = std::to_string(e.code().value()); 
 				std::string error = std::string("When joining thread caught system_error with code ") + "[" + error_code_str + "] meaning " + "[" + e.what() + "]";
-				std::time_t error_time = std::time(nullptr);
-				{
-					std::lock_guard<std::mutex> cm(cout_mutex);
-					std::cerr << error << '\n';
-				}
 				if (logger_flag.load()) {
-					std::lock_guard<std::mutex> lm(logger_mutex);
-					logger.log_error(error_time, error);
+					logger.log_error(std::time(nullptr), error);
 				}
+				events.publish(MT::TaskEventType::pool_error, 0, std::move(error));
             }
         }
 	}
@@ -95,7 +341,14 @@ void MT::ThreadPool::start() {
     if (paused.load() == true) {
         paused.store(false);
         // даем всем потокам разрешающий сигнал для доступа к очереди невыполненных задач
+		{
+			std::lock_guard<std::mutex> sl(sleep_mutex);
+		}
         tasks_access.notify_all();
+		// пока пул стоял, потоки эластичного пула могли завершиться
+		if (controller) {
+			controller->notify();
+		}
 		// логируем
 		if (logger_flag) {
 			logger.log_start(std::time(nullptr));
@@ -106,7 +359,7 @@ void MT::ThreadPool::start() {
 
 
 bool MT::ThreadPool::is_comleted() const {
-	return completed_task_count + incomplete_tasks_with_an_error.size() == last_task_id;
+	return completed_task_count.load() + failed_task_count.load() == last_task_id.load();
 }
 
 
@@ -115,226 +368,745 @@ void MT::ThreadPool::set_logger_flag(bool flag) {
 }
 
 
+void MT::ThreadPool::set_event_sink(std::shared_ptr<MT::EventSink> sink) {
+	events.set_sink(std::move(sink));
+}
+
+
 void MT::ThreadPool::clear_completed() {
-	std::lock_guard<std::mutex> lock(completed_tasks_mutex);
 	completed_tasks.clear();
 	return;
 }
 
 
-bool MT::ThreadPool::run_allowed() const {
-	return (!task_queue.empty() && !paused.load());
+MT::ResultStoreStats MT::ThreadPool::result_store_stats() {
+	return completed_tasks.stats();
 }
 
 
-void MT::ThreadPool::run(MT::Thread& _thread) {
-   while (!stopped.load()) {
-        std::unique_lock<std::mutex> lock(task_queue_mutex);
+size_t MT::ThreadPool::current_node() const {
+	if (node_queues.empty()) {
+		return 0;
+	}
+	if (current_pool == this) {
+		return current_thread->node;
+	}
+	int cpu = MT::current_cpu();
+	if (cpu >= 0 && static_cast<size_t>(cpu) < cpu_nodes.size()) {
+		return cpu_nodes[cpu];
+	}
+	return 0;
+}
 
-        tasks_access.wait(lock, [this]() -> bool { return run_allowed() || stopped.load(); });
 
+size_t MT::ThreadPool::count_of_nodes() const {
+	return node_queues.empty() ? 1 : node_queues.size();
+}
 
-        if (run_allowed()) {
-            std::shared_ptr<Task> task = std::move(task_queue.front());
-            _thread.is_working.store(true);
-            task_queue.pop();
-			lock.unlock();
 
-			std::time_t start_time = std::time(nullptr);
+bool MT::ThreadPool::is_remote_job(const MT::Job* job) const {
+	return !node_queues.empty() && job->node != MT::any_node && job->node % node_queues.size() != current_node();
+}
 
-			try {
-            	task->one_thread_pre_method();
-			} catch (const std::exception& e) {
-				std::time_t error_time = std::time(nullptr);
-				std::string error = std::string("Error when solving a problem with an id: ") + std::to_string(task->task_id) + ".\nException: " + e.what();
-				std::lock_guard<std::mutex> cm(cout_mutex);
-				std::cerr << error << '\n';
 
-				if (logger_flag.load()) {
-					std::lock_guard<std::mutex> lm(logger_mutex);
-					logger.log_error(error_time, error);
-				}
-				std::lock_guard<std::mutex> itm(incomplete_tasks_with_an_error_mutex);
-				incomplete_tasks_with_an_error.insert(task->task_id);
-				continue;
-			} catch (...) {
-				std::time_t error_time = std::time(nullptr);
-				std::lock_guard<std::mutex> cm(cout_mutex);
-				std::string error = std::string("Unknown error in task id: ") + std::to_string(task->task_id);
-				std::cerr << error << '\n';
+MT::ThreadPool::SharedJobQueue& MT::ThreadPool::node_queue_for(const MT::Job* job) {
+	size_t node = job->node != MT::any_node ? job->node % node_queues.size() : current_node();
+	return *node_queues[node];
+}
 
-				if (logger_flag.load()) {
-					std::lock_guard<std::mutex> lm(logger_mutex);
-					logger.log_error(error_time, error);
-				}
-				std::lock_guard<std::mutex> itm(incomplete_tasks_with_an_error_mutex);
-				incomplete_tasks_with_an_error.insert(task->task_id);
-				continue;
-			}
 
-			std::time_t end_time = std::time(nullptr);
+void MT::ThreadPool::push_to_shared(SharedJobQueue& queue, MT::Job* job) {
+	std::unique_lock<std::mutex> lock = lock_queue(queue.mutex);
+	queue.jobs.push(job);
+	queue.size.fetch_add(1);
+}
 
-            if (logger_flag.load()) {
-				std::lock_guard<std::mutex> lg(logger_mutex);
-				logger.add_record_about_task(start_time, end_time, task->description);
-			}
 
-            std::lock_guard<std::mutex> lg(completed_tasks_mutex);
-			completed_tasks[task->task_id] = std::move(task);
-			++completed_task_count;
-			_thread.is_working.store(false);
-        }
-		wait_access.notify_one();
-    }
+MT::PriorityStats MT::ThreadPool::priority_stats(MT::TaskPriority priority) {
+	MT::PriorityStats stats;
+	size_t high = high_tasks.size.load();
+	size_t low = low_tasks.size.load();
+	switch (priority) {
+		case MT::TaskPriority::high:
+			stats.queued = high;
+			break;
+		case MT::TaskPriority::low:
+			stats.queued = low;
+			break;
+		case MT::TaskPriority::normal: {
+			// счётчики читаются не одновременно, поэтому разность может быть отрицательной
+			size_t queued = queued_count();
+			stats.queued = queued > high + low ? queued - high - low : 0;
+			break;
+		}
+	}
+
+	MT::LatencyHistogram histogram;
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), actual_threads_count.load())) {
+		if (threads[i].latency) {
+			threads[i].latency->add_priority_wait(priority, histogram);
+		}
+	}
+	stats.started = histogram.count();
+	stats.wait_mean = histogram.mean();
+	stats.wait_p50 = histogram.percentile(0.5);
+	stats.wait_p99 = histogram.percentile(0.99);
+	stats.wait_max = histogram.max();
+	return stats;
 }
 
 
-void MT::ThreadPool::wait() {
-	std::lock_guard<std::mutex> lock_wait(wait_mutex);
+MT::LatencySnapshot MT::ThreadPool::latency_snapshot() {
+	MT::LatencyRecorder::Histograms overall;
+	std::map<std::string, std::unique_ptr<MT::LatencyRecorder::Histograms>> by_type;
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), actual_threads_count.load())) {
+		if (threads[i].latency) {
+			threads[i].latency->add_overall(overall);
+			threads[i].latency->add_by_type(by_type);
+		}
+	}
 
-	start();
+	MT::LatencySnapshot snapshot;
+	snapshot.overall = overall.breakdown();
+	for (const auto& [name, histograms] : by_type) {
+		snapshot.by_task_type.emplace(name, histograms->breakdown());
+	}
+	return snapshot;
+}
 
-	std::unique_lock<std::mutex> lock(task_queue_mutex);
-	wait_access.wait(lock, [this]()->bool { return is_comleted(); });
 
-	pause();
+MT::PoolStats MT::ThreadPool::stats() {
+	MT::PoolStats stats;
+	// завершённые читаются раньше добавленных: задача учитывается в submitted до выполнения
+	stats.completed = completed_task_count.load();
+	stats.failed = failed_task_count.load();
+	stats.submitted = last_task_id.load();
+	stats.queue_depth = queued_count();
+	stats.threads = live_threads.load();
+	stats.sleeping_threads = sleeping_threads.load();
+	stats.threads_started = threads_started.load();
+	stats.threads_retired = threads_retired.load();
+	stats.lock_contentions = external_lock_contentions.load(std::memory_order_relaxed);
+
+	size_t count = actual_threads_count.load();
+	stats.workers.reserve(count);
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), count)) {
+		const MT::Thread& slot = threads[i];
+		MT::WorkerStats worker;
+		worker.index = slot.index;
+		worker.alive = slot.is_alive.load();
+		worker.working = slot.is_working.load();
+		worker.cpu = slot.cpu;
+		worker.node = slot.node;
+		worker.executed = slot.counters.executed.load(std::memory_order_relaxed);
+		worker.failed = slot.counters.failed.load(std::memory_order_relaxed);
+		worker.steals = slot.counters.steals.load(std::memory_order_relaxed);
+		worker.lock_contentions = slot.counters.lock_contentions.load(std::memory_order_relaxed);
+		worker.busy_time = std::chrono::nanoseconds(slot.counters.busy_ns.load(std::memory_order_relaxed));
+
+		stats.working_threads += worker.working;
+		stats.steals += worker.steals;
+		stats.lock_contentions += worker.lock_contentions;
+		stats.workers.push_back(worker);
+	}
+	return stats;
 }
 
 
-void MT::ThreadPool::get_result(size_t task_id) {
-	std::lock_guard<std::mutex> lock(completed_tasks_mutex);
-	std::lock_guard<std::mutex> cl(cout_mutex);
-	auto it = completed_tasks.find(task_id);
-	if (it != completed_tasks.end()) {
-		std::cout << "Result [" << task_id << "]:\n";
-		it->second->show_result();
-	} else if (task_id > last_task_id || task_id <= 0) {
-		std::cout << "Unknown task ID\n";
-	} else {
-		std::lock_guard<std::mutex> itm(incomplete_tasks_with_an_error_mutex);
-		if (incomplete_tasks_with_an_error.contains(task_id)) {
-			std::cout << "An error occurred while completing the task\n";
+std::unique_lock<std::mutex> MT::ThreadPool::lock_queue(std::mutex& mutex) {
+	// без соперника try_lock стоит столько же, сколько lock
+	std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+	if (!lock.owns_lock()) {
+		if (current_pool == this) {
+			MT::WorkerCounters::add(current_thread->counters.lock_contentions);
 		} else {
-			std::cout << "Result [" << task_id << "]: still processing...\n";
+			external_lock_contentions.fetch_add(1, std::memory_order_relaxed);
 		}
+		lock.lock();
 	}
-	return;
+	return lock;
 }
 
 
-size_t MT::ThreadPool::count_working_threads() {
-	size_t result = 0;
-	for (uint16_t i : std::ranges::iota_view(0u, threads.size())) {
-		result += threads[i].is_working.load();
+bool MT::ThreadPool::run_allowed() const {
+	return (queued_tasks.load() != 0 && !paused.load());
+}
+
+
+MT::TaskFunction MT::ThreadPool::wrap_task(std::shared_ptr<Task> task) {
+	return MT::TaskFunction([this, task = std::move(task)]() {
+		task->one_thread_pre_method();
+		completed_tasks.insert(task->task_id, task);
+	});
+}
+
+
+size_t MT::ThreadPool::push_task(std::shared_ptr<Task> task, MT::TaskPriority priority) {
+	Task* raw_task = task.get();
+	return push_job(wrap_task(std::move(task)), raw_task, nullptr, priority);
+}
+
+
+size_t MT::ThreadPool::push_job(MT::TaskFunction&& fn, MT::Task* task, MT::JobListener* listener,
+								MT::TaskPriority priority) {
+	// задаём уникальный идентификатор новой задаче, минимальный id равен 1
+	size_t task_id = last_task_id.fetch_add(1) + 1;
+	MT::Job* job = MT::JobPool::allocate();
+	if (task != nullptr) {
+		task->task_id = task_id;
+		// связываем задачу с текущим пулом
+		task->thread_pool = this;
+		job->node = task->node_hint;
 	}
-	return result;
+
+	job->fn = std::move(fn);
+	job->task_id = task_id;
+	job->task = task;
+	job->listener = listener;
+	job->priority = priority;
+	if (priority != MT::TaskPriority::normal || options.latency_metrics) {
+		// для low время постановки нужно и без метрик - по нему задача «стареет»
+		job->enqueue_time = std::chrono::steady_clock::now();
+	}
+
+	// задача учитывается до того, как станет видна потокам: иначе поток может забрать её
+	// и уменьшить queued_tasks раньше, чем счётчик будет увеличен
+	queued_tasks.fetch_add(1);
+	if (priority != MT::TaskPriority::normal) {
+		// задачи с приоритетом идут в отдельные общие очереди, мимо деков потоков,
+		// чтобы их мог взять любой поток, а не только владелец дека
+		push_to_shared(priority == MT::TaskPriority::high ? high_tasks : low_tasks, job);
+	} else if (is_remote_job(job)) {
+		// данные задачи лежат на другом узле - отдаём её потокам этого узла
+		push_to_shared(node_queue_for(job), job);
+	} else if (options.queue_type != MT::QueueType::global_queue && current_pool == this) {
+		// задача порождена другой задачей - кладём в свой дек, без общих блокировок
+		current_thread->local_tasks->push(job);
+	} else if (options.queue_type == MT::QueueType::bounded_ring) {
+		if (!push_to_ring(job)) {
+			queued_tasks.fetch_sub(1);
+			reject_job(job);
+			return 0;
+		}
+	} else if (!node_queues.empty()) {
+		push_to_shared(node_queue_for(job), job);
+	} else {
+		std::unique_lock<std::mutex> lock = lock_queue(task_queue_mutex);
+		task_queue.push(job);
+	}
+
+	// Сообщаем о добавлении задачи уже после снятия блокировки очереди
+	events.publish(MT::TaskEventType::submitted, task_id);
+	notify_workers(1);
+	return task_id;
 }
 
 
-size_t MT::ThreadPool::count_of_threads() {
-	return threads.size();
+std::pair<size_t, size_t> MT::ThreadPool::push_tasks(std::vector<std::shared_ptr<Task>>&& tasks, MT::JobListener* listener) {
+	std::vector<MT::Job*> jobs(tasks.size());
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), tasks.size())) {
+		jobs[i] = MT::JobPool::allocate();
+		jobs[i]->task = tasks[i].get();
+		jobs[i]->fn = wrap_task(std::move(tasks[i]));
+		jobs[i]->listener = listener;
+	}
+	return push_jobs(std::move(jobs));
 }
 
 
-size_t MT::ThreadPool::count_waiting_threads() {
-	size_t result = 0;
-	for (uint16_t i : std::ranges::iota_view(0u, threads.size())) {
-		result += threads[i].is_waiting.load();
+std::pair<size_t, size_t> MT::ThreadPool::push_jobs(std::vector<MT::Job*>&& jobs) {
+	size_t count = jobs.size();
+	size_t first_id = last_task_id.fetch_add(count) + 1;
+	if (count == 0) {
+		return {first_id, first_id};
 	}
-	return result;
+
+	std::chrono::steady_clock::time_point now;
+	if (options.latency_metrics) {
+		now = std::chrono::steady_clock::now();
+	}
+
+	// число задач, которые уже лежат в очереди, но о которых потоки ещё не оповещены;
+	// в queued_tasks задачи учитываются до того, как станут видны потокам (см. push_job)
+	size_t accepted = 0;
+
+	// узлы готовим до захвата очереди; работы для других узлов NUMA сразу уходят в их очереди
+	size_t kept = 0;
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), count)) {
+		MT::Job* job = jobs[i];
+		job->task_id = first_id + i;
+		job->enqueue_time = now;
+		if (job->task != nullptr) {
+			job->task->task_id = first_id + i;
+			job->task->thread_pool = this;
+			job->node = job->task->node_hint;
+		}
+		if (is_remote_job(job)) {
+			queued_tasks.fetch_add(1);
+			push_to_shared(node_queue_for(job), job);
+			++accepted;
+			continue;
+		}
+		// остальные связываем в список
+		if (kept != 0) {
+			jobs[kept - 1]->next = job;
+		}
+		jobs[kept++] = job;
+	}
+	jobs.resize(kept);
+
+	if (jobs.empty()) {
+		// все работы ушли в очереди других узлов
+	} else if (options.queue_type != MT::QueueType::global_queue && current_pool == this) {
+		queued_tasks.fetch_add(jobs.size());
+		for (MT::Job* job : jobs) {
+			job->next = nullptr;
+			current_thread->local_tasks->push(job);
+		}
+		accepted += jobs.size();
+	} else if (options.queue_type == MT::QueueType::bounded_ring) {
+		for (MT::Job* job : jobs) {
+			job->next = nullptr;
+			queued_tasks.fetch_add(1);
+			if (!ring_queue->try_push(job)) {
+				// буфер заполнен - сначала будим потоки для уже добавленных задач,
+				// иначе при FullQueuePolicy::block место никогда не освободится
+				notify_workers(accepted);
+				accepted = 0;
+				if (!push_to_ring(job)) {
+					queued_tasks.fetch_sub(1);
+					reject_job(job);
+					continue;
+				}
+			}
+			++accepted;
+		}
+	} else if (!node_queues.empty()) {
+		// готовый список присоединяется к очереди узла за O(1)
+		SharedJobQueue& queue = *node_queues[current_node()];
+		queued_tasks.fetch_add(jobs.size());
+		std::unique_lock<std::mutex> lock = lock_queue(queue.mutex);
+		queue.jobs.append(jobs.front(), jobs.back());
+		queue.size.fetch_add(jobs.size());
+		accepted += jobs.size();
+	} else {
+		// готовый список присоединяется к очереди за O(1)
+		queued_tasks.fetch_add(jobs.size());
+		std::unique_lock<std::mutex> lock = lock_queue(task_queue_mutex);
+		task_queue.append(jobs.front(), jobs.back());
+		accepted += jobs.size();
+	}
+
+	if (events.is_enabled()) {
+		for (size_t i : std::ranges::iota_view(first_id, first_id + count)) {
+			events.publish(MT::TaskEventType::submitted, i);
+		}
+	}
+	notify_workers(accepted);
+	return {first_id, first_id + count};
 }
 
 
-MT::ThreadPoolController::ThreadPoolController(MT::ThreadPool& pool_ref) : pool(pool_ref) {
-	controller_thread = std::move(std::thread(&ThreadPoolController::monitor, this));
-	
+bool MT::ThreadPool::push_to_ring(MT::Job* job) {
+	if (ring_queue->try_push(job)) {
+		return true;
+	}
+
+	switch (options.full_queue_policy) {
+		case MT::FullQueuePolicy::fail:
+			return false;
+
+		case MT::FullQueuePolicy::spin:
+			while (!ring_queue->try_push(job)) {
+				std::this_thread::yield();
+			}
+			return true;
+
+		case MT::FullQueuePolicy::block: {
+			std::unique_lock<std::mutex> lock(space_mutex);
+			blocked_producers.fetch_add(1);
+			// парный барьер стоит в take_job после извлечения задачи
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			space_access.wait(lock, [this, job]() -> bool { return ring_queue->try_push(job); });
+			blocked_producers.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
 }
 
 
-MT::ThreadPoolController::~ThreadPoolController() {
-	stopped.store(true);
-	if (controller_thread.joinable()) {
-		controller_thread.join();
+MT::Job* MT::ThreadPool::take_job(MT::Thread& _thread) {
+	MT::Job* job = nullptr;
+
+	// high берётся первым, но не больше high_priority_burst раз подряд
+	bool high_allowed = _thread.high_streak < options.high_priority_burst;
+	if (high_allowed) {
+		job = take_shared_job(high_tasks, false);
+	}
+
+	if (job != nullptr) {
+		++_thread.high_streak;
+	} else {
+		// low, прождавшая дольше low_priority_aging, обгоняет normal
+		job = take_shared_job(low_tasks, true);
+		if (job == nullptr) {
+			job = take_normal_job(_thread);
+		}
+		if (job == nullptr && !high_allowed) {
+			// других задач нет - лимит high не должен задерживать её выполнение
+			job = take_shared_job(high_tasks, false);
+		}
+		if (job == nullptr) {
+			job = take_shared_job(low_tasks, false);
+		}
+		if (job != nullptr) {
+			_thread.high_streak = job->priority == MT::TaskPriority::high ? 1 : 0;
+		}
+	}
+
+	if (job != nullptr) {
+		queued_tasks.fetch_sub(1);
 	}
+	return job;
 }
 
 
-void MT::ThreadPoolController::monitor() {
-	while(!stopped.load()) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        check_for_deadlock();
+MT::Job* MT::ThreadPool::take_shared_job(SharedJobQueue& queue, bool only_aged) {
+	if (queue.size.load() == 0) {
+		return nullptr;
+	}
+
+	std::unique_lock<std::mutex> lock = lock_queue(queue.mutex);
+	if (queue.jobs.empty()) {
+		return nullptr;
 	}
+	if (only_aged && std::chrono::steady_clock::now() - queue.jobs.head->enqueue_time < options.low_priority_aging) {
+		return nullptr;
+	}
+	queue.size.fetch_sub(1);
+	return queue.jobs.pop();
 }
 
 
-void MT::ThreadPoolController::check_for_deadlock() {
-	size_t count_of_threads = pool.count_of_threads();
-	size_t count_of_waiting_threads = pool.count_waiting_threads();
+MT::Job* MT::ThreadPool::take_normal_job(MT::Thread& _thread) {
+	MT::Job* job = nullptr;
 
-	if (count_of_threads == count_of_waiting_threads) {
-		std::time_t deadlock_time = std::time(nullptr);
-		{
-			std::lock_guard<std::mutex> cm(pool.cout_mutex);
-			std::cerr << "Deadlock detected! Expanding pool...\n";
+	if (options.queue_type != MT::QueueType::global_queue) {
+		if (std::optional<MT::Job*> local = _thread.local_tasks->pop()) {
+			job = *local;
 		}
+	}
 
-		if (pool.logger_flag.load()) {
-			std::lock_guard<std::mutex> lm(pool.logger_mutex);
-			pool.logger.log_deadlock(deadlock_time, pool.count_of_threads());
+	if (job == nullptr && !node_queues.empty()) {
+		job = take_shared_job(*node_queues[_thread.node], false);
+	}
+
+	if (job == nullptr && ring_queue) {
+		if (ring_queue->try_pop(job)) {
+			// парный барьер стоит в push_to_ring перед ожиданием места
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (blocked_producers.load() != 0) {
+				{
+					std::lock_guard<std::mutex> sm(space_mutex);
+				}
+				space_access.notify_one();
+			}
 		}
-		pool.expand();
+	} else if (job == nullptr && node_queues.empty()) {
+		std::unique_lock<std::mutex> lock = lock_queue(task_queue_mutex);
+		job = task_queue.pop();
+	}
+
+	if (job == nullptr && options.queue_type != MT::QueueType::global_queue) {
+		job = steal_job(_thread, true);
 	}
-}
 
+	if (job == nullptr && !node_queues.empty()) {
+		// на своём узле работы нет - помогаем остальным узлам
+		for (size_t i : std::ranges::iota_view(static_cast<size_t>(1), node_queues.size())) {
+			job = take_shared_job(*node_queues[(_thread.node + i) % node_queues.size()], false);
+			if (job != nullptr) {
+				break;
+			}
+		}
+		if (job == nullptr && options.queue_type != MT::QueueType::global_queue) {
+			job = steal_job(_thread, false);
+		}
+	}
+	return job;
+}
 
-void MT::ThreadPool::expand() {
-	if (count_of_threads() == max_threads) {
-		std::string error_str = "The number of open threads has exceeded the maximum allowed limit.";
-		std::time_t error_time = std::time(nullptr);
 
-		{
-			std::lock_guard<std::mutex> cm(cout_mutex);
-			std::cerr << error_str << "\nFurther pool operation is not possible\n";
+MT::Job* MT::ThreadPool::steal_job(MT::Thread& _thread, bool same_node) {
+	// обходим остальные потоки, начиная со следующего за текущим
+	size_t count = actual_threads_count.load();
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(1), count)) {
+		MT::Thread& victim = threads[(_thread.index + i) % count];
+		if ((victim.node == _thread.node) != same_node) {
+			continue;
+		}
+		if (std::optional<MT::Job*> stolen = victim.local_tasks->steal()) {
+			MT::WorkerCounters::add(_thread.counters.steals);
+			return *stolen;
 		}
+	}
+	return nullptr;
+}
 
-		if (logger_flag.load()) {
-			std::lock_guard<std::mutex> lm(logger_mutex);
-			logger.log_error(error_time, error_str);
+
+void MT::ThreadPool::notify_workers(size_t count) {
+	// sleeping_threads увеличивается под sleep_mutex до проверки queued_tasks,
+	// поэтому либо поток увидит новую задачу, либо мы увидим спящий поток
+	size_t sleeping = sleeping_threads.load();
+	if (count == 0) {
+		return;
+	}
+	if (controller && queued_tasks.load() > sleeping) {
+		// спящих потоков не хватит на всю очередь - решение о росте пула принимает контроллер
+		controller->notify();
+	}
+	if (sleeping == 0) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> sl(sleep_mutex);
+	}
+	if (count >= sleeping) {
+		tasks_access.notify_all();
+	} else {
+		for ([[maybe_unused]] size_t i : std::ranges::iota_view(static_cast<size_t>(0), count)) {
+			tasks_access.notify_one();
 		}
-		throw;
 	}
-    std::lock_guard<std::mutex> lock(task_queue_mutex);
-    try {
-		threads.emplace_back();
-		threads.back()._thread = std::move(std::thread(&ThreadPool::run, this, std::ref(threads.back())));
-		threads.back().is_working.store(false);
-		threads.back().is_waiting.store(false);
-		actual_threads_count++;
-	} catch (const std::system_error& e) {
-		std::string error_code_str = std::to_string(e.code().value()); 
-		std::string error = std::string("When creating thread caught system_error with code ") + "[" + error_code_str + "] meaning " + "[" + e.what() + "]";
-		std::time_t error_time = std::time(nullptr);
-		
+}
+
+
+void MT::ThreadPool::reject_job(MT::Job* job) {
+	// задача отклонена: считаем её завершённой с ошибкой, чтобы wait() не ждал её вечно
+	size_t task_id = job->task_id;
+	MT::JobListener* listener = job->listener;
+	MT::JobPool::release(job);
+	if (listener != nullptr) {
+		listener->on_job_finished(std::make_exception_ptr(std::runtime_error("Task queue is full")));
+	}
+	completed_tasks.insert_failure(task_id);
+	failed_task_count.fetch_add(1);
+	notify_if_completed();
+}
+
+
+void MT::ThreadPool::notify_if_completed() {
+	if (is_comleted()) {
 		{
-			std::lock_guard<std::mutex> cm(cout_mutex);
-			std::cerr << error << '\n';
+			std::lock_guard<std::mutex> sl(sleep_mutex);
 		}
-		std::lock_guard<std::mutex> lm(logger_mutex);
-		logger.log_error(error_time, error);
-		--actual_threads_count;
-		throw;
+		wait_access.notify_all();
 	}
 }
 
 
-void MT::ThreadPool::set_current_thread_waiting(bool waiting_status) {
-	std::thread::id current_id = std::this_thread::get_id();
-	for (auto& thread : threads) {
-		if (thread._thread.get_id() == current_id) {
-			thread.is_waiting.store(waiting_status);
-			return;
+void MT::ThreadPool::run(MT::Thread& _thread) {
+	current_thread = &_thread;
+	current_pool = this;
+
+	if (_thread.cpu >= 0 && !MT::pin_current_thread(_thread.cpu)) {
+		// без привязки пул продолжает работать, но об этом стоит знать
+		logger.log_error(std::time(nullptr), "Failed to pin a pool thread to CPU " + std::to_string(_thread.cpu));
+	}
+
+	while (!stopped.load()) {
+		if (!run_allowed()) {
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			sleeping_threads.fetch_add(1);
+			bool woken = true;
+			if (controller) {
+				woken = tasks_access.wait_for(lock, options.keep_alive, [this]() -> bool { return run_allowed() || stopped.load(); });
+			} else {
+				tasks_access.wait(lock, [this]() -> bool { return run_allowed() || stopped.load(); });
+			}
+			sleeping_threads.fetch_sub(1);
+
+			// задача, добавленная до уменьшения sleeping_threads, видна здесь; добавленная после -
+			// не найдёт спящего потока и разбудит контроллер
+			if (!woken && !run_allowed() && retire_worker()) {
+				break;
+			}
+		}
+
+		if (stopped.load()) {
+			break;
+		}
+
+		MT::Job* job = take_job(_thread);
+		if (job == nullptr) {
+			// задачу успел забрать другой поток
+			std::this_thread::yield();
+			continue;
+		}
+
+		_thread.is_working.store(true);
+		execute_job(job);
+		_thread.is_working.store(false);
+		notify_if_completed();
+	}
+
+	current_thread = nullptr;
+	current_pool = nullptr;
+	_thread.is_alive.store(false);
+}
+
+
+void MT::ThreadPool::execute_job(MT::Job* job) {
+	size_t task_id = job->task_id;
+	MT::JobListener* listener = job->listener;
+	std::time_t start_time = std::time(nullptr);
+	events.publish(MT::TaskEventType::started, task_id);
+
+	std::chrono::steady_clock::time_point dequeue_time;
+	if (options.latency_metrics) {
+		dequeue_time = std::chrono::steady_clock::now();
+	}
+
+	// текст ошибки, пустой при успешном выполнении
+	std::string error;
+	// само исключение нужно только получателю уведомления
+	std::exception_ptr job_error;
+
+	try {
+		job->fn();
+	} catch (const std::exception& e) {
+		error = std::string("Error when solving a problem with an id: ") + std::to_string(task_id) + ".\nException: " + e.what();
+		job_error = std::current_exception();
+	} catch (...) {
+		error = std::string("Unknown error in task id: ") + std::to_string(task_id);
+		job_error = std::current_exception();
+	}
+
+	// execute_job вызывается только потоками пула
+	MT::WorkerCounters& counters = current_thread->counters;
+	MT::WorkerCounters::add(counters.executed);
+	if (!error.empty()) {
+		MT::WorkerCounters::add(counters.failed);
+	}
+	if (options.latency_metrics) {
+		std::chrono::steady_clock::time_point completion_time = std::chrono::steady_clock::now();
+		std::chrono::nanoseconds execution = completion_time - dequeue_time;
+		current_thread->latency->record(job->task != nullptr ? &typeid(*job->task) : nullptr, job->priority,
+										dequeue_time - job->enqueue_time, execution);
+		MT::WorkerCounters::add(counters.busy_ns, static_cast<uint64_t>(execution.count()));
+	}
+
+	if (error.empty() && logger_flag.load()) {
+		// описание строится только при включённом журнале
+		std::time_t end_time = std::time(nullptr);
+		if (job->task != nullptr) {
+			logger.add_record_about_task(start_time, end_time, job->task->describe());
+		} else {
+			logger.add_record_about_task(start_time, end_time, "Callable task\n");
 		}
 	}
+
+	// узел (и задача, если пул был её последним владельцем) освобождается
+	// до учёта результата, чтобы после wait() пул не держал ссылок на задачи
+	MT::JobPool::release(job);
+
+	// следующие задачи (например, узлы графа) должны попасть в пул до учёта этой
+	if (listener != nullptr) {
+		listener->on_job_finished(std::move(job_error));
+	}
+
+	if (!error.empty()) {
+		if (logger_flag.load()) {
+			logger.log_error(std::time(nullptr), error);
+		}
+		events.publish(MT::TaskEventType::failed, task_id, std::move(error));
+
+		completed_tasks.insert_failure(task_id);
+		failed_task_count.fetch_add(1);
+	} else {
+		events.publish(MT::TaskEventType::finished, task_id);
+		completed_task_count.fetch_add(1);
+	}
+}
+
+
+void MT::ThreadPool::run_graph(MT::TaskGraph& graph) {
+	graph.launch(*this);
 }
 
 
+bool MT::ThreadPool::run_pending_task() {
+	if (current_pool != this || paused.load()) {
+		return false;
+	}
+	MT::Job* job = take_job(*current_thread);
+	if (job == nullptr) {
+		return false;
+	}
+	execute_job(job);
+	notify_if_completed();
+	return true;
+}
+
+
+void MT::ThreadPool::wake_helpers() {
+	{
+		std::lock_guard<std::mutex> sl(sleep_mutex);
+	}
+	tasks_access.notify_all();
+}
+
+
+bool MT::ThreadPool::is_pool_thread() const {
+	return current_pool == this;
+}
+
+
+void MT::ThreadPool::wait() {
+	std::lock_guard<std::mutex> lock_wait(wait_mutex);
+
+	start();
+
+	std::unique_lock<std::mutex> lock(sleep_mutex);
+	wait_access.wait(lock, [this]()->bool { return is_comleted(); });
+	lock.unlock();
+
+	pause();
+}
+
+
+void MT::ThreadPool::get_result(size_t task_id) {
+	// задачу достаём под блокировкой шарда, а печатаем уже без неё
+	auto [task, failed] = completed_tasks.lookup(task_id);
+
+	std::lock_guard<std::mutex> cl(MT::console_mutex());
+	if (task != nullptr) {
+		std::cout << "Result [" << task_id << "]:\n";
+		task->show_result();
+	} else if (task_id > last_task_id.load() || task_id <= 0) {
+		std::cout << "Unknown task ID\n";
+	} else if (failed) {
+		std::cout << "An error occurred while completing the task\n";
+	} else if (completed_tasks.is_bounded()) {
+		// выполненная задача могла быть уже вытеснена из хранилища
+		std::cout << "Result [" << task_id << "]: still processing or no longer stored\n";
+	} else {
+		std::cout << "Result [" << task_id << "]: still processing...\n";
+	}
+	return;
+}
+
+
+size_t MT::ThreadPool::count_working_threads() {
+	size_t result = 0;
+	for (size_t i : std::ranges::iota_view(static_cast<size_t>(0), actual_threads_count.load())) {
+		result += threads[i].is_working.load();
+	}
+	return result;
+}
+
+
+size_t MT::ThreadPool::count_of_threads() {
+	return live_threads.load();
+}
@@ -1,6 +1,8 @@
 #pragma once 
 #include <iostream>
 #include <cstdint>
+#include <array>
+#include <chrono>
 #include <ranges>
 #include <vector>
 #include <queue>
@@ -9,22 +11,48 @@
 #include <condition_variable>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <concepts>
+#include <iterator>
+#include <functional>
+#include <stdexcept>
 #include "Logger.h"
+#include "work_stealing_deque.h"
+#include "mpmc_queue.h"
+#include "event_sink.h"
+#include "task_future.h"
+#include "task_function.h"
+#include "job.h"
+#include "result_store.h"
+#include "latency_recorder.h"
+#include "topology.h"
+#include "pool_stats.h"
 
 
 namespace MT {
 
     class ThreadPool;
 
+    class TaskGroup;
+
+    class TaskGraph;
+
     // Нужен класс - обёртка для задачи
     class Task {
         friend class ThreadPool;
+        friend class TaskGraph;
      public:
         enum class TaskStatus {
             awating,
             completed
         };
 
+        // описание формируется лениво - наследник переопределяет describe()
+        Task();
+
+        // статическое описание (строковый литерал), строка не копируется
+        Task(const char* description_);
+
         Task(const std::string& description_);
 
         // абстрактный метод, который должен быть реализован пользователем,
@@ -35,6 +63,17 @@ namespace MT {
         // где реализованв вывод в консоль
         void virtual show_result() = 0;
 
+        // описание задачи для журнала, собирается только тогда, когда действительно нужно
+        virtual std::string describe() const;
+
+        // примерный объём памяти, который занимает задача вместе с результатом,
+        // используется ограничением ResultRetention::max_bytes
+        virtual size_t memory_footprint() const;
+
+        // узел NUMA, на котором задачу лучше выполнить (например, там, где лежат её данные),
+        // учитывается при ThreadPlacement::numa_nodes; см. ThreadPool::current_node
+        void prefer_node(size_t node);
+
         virtual ~Task() = default;
 
      protected:
@@ -42,6 +81,9 @@ namespace MT {
         // Для красивого логирования
         std::string description;
 
+        // описание, переданное строковым литералом
+        const char* static_description;
+
         size_t task_id;
 
         MT::Task::TaskStatus status;
@@ -49,85 +91,274 @@ namespace MT {
         //для возможности добавления новых задач в пул прямо из задачи
         MT::ThreadPool* thread_pool; 
 
+        // предпочтительный узел NUMA или MT::any_node
+        size_t node_hint;
+
         // метод, запускаемый потоком
         void one_thread_pre_method();
     };
 
 
+    // Способ организации очереди задач
+    enum class QueueType {
+        // одна общая очередь под task_queue_mutex
+        global_queue,
+        // у каждого потока свой дек, задачи извне попадают в общую очередь
+        work_stealing,
+        // как work_stealing, но задачи извне попадают в ограниченный lock-free кольцевой буфер
+        bounded_ring
+    };
+
+
+    // Поведение add_task при заполненном кольцевом буфере
+    enum class FullQueuePolicy {
+        // задача отклоняется, add_task возвращает 0
+        fail,
+        // поток засыпает, пока в буфере не освободится место
+        // (на приостановленном пуле место не освободится, пока не вызван start() или wait())
+        block,
+        // поток крутится в цикле, уступая процессор
+        spin
+    };
+
+
+    // Размещение потоков пула по процессорам
+    enum class ThreadPlacement {
+        // потоками распоряжается планировщик ОС
+        none,
+        // каждый поток привязан к своему процессору, потоки распределяются по узлам NUMA по очереди
+        pin_cores,
+        // как pin_cores, но у каждого узла своя очередь задач извне пула, а кража
+        // начинается с потоков своего узла, чтобы задачи выполнялись рядом со своими данными
+        numa_nodes
+    };
+
+
+    // Параметры пула
+    struct PoolOptions {
+        MT::QueueType queue_type = MT::QueueType::work_stealing;
+
+        // ёмкость кольцевого буфера (только для QueueType::bounded_ring)
+        size_t ring_capacity = 1 << 16;
+        MT::FullQueuePolicy full_queue_policy = MT::FullQueuePolicy::block;
+
+        // файл журнала и поведение при переполнении буфера записей потока
+        std::string log_path = "../log_file.txt";
+        LogOverflowPolicy log_overflow_policy = LogOverflowPolicy::drop;
+
+        // ограничения хранилища результатов, по умолчанию результаты хранятся до clear_completed()
+        MT::ResultRetention result_retention;
+
+        // после стольких задач с TaskPriority::high подряд поток берёт одну задачу с более низким приоритетом
+        size_t high_priority_burst = 16;
+        // задача с TaskPriority::low, прождавшая дольше, обгоняет задачи с TaskPriority::normal
+        std::chrono::milliseconds low_priority_aging{100};
+
+        // замер времени ожидания и выполнения задач (steady_clock) для ThreadPool::latency_snapshot
+        // и ThreadPool::priority_stats
+        bool latency_metrics = true;
+
+        // границы числа потоков эластичного пула; при max_threads == 0 размер пула
+        // фиксирован и равен числу потоков, переданному в конструктор
+        size_t min_threads = 0;
+        size_t max_threads = 0;
+        // пул растёт, если на поток приходится больше grow_queue_depth задач в очереди
+        // или если за grow_after ни одна задача не покинула очередь
+        size_t grow_queue_depth = 64;
+        std::chrono::milliseconds grow_after{50};
+        // поток, простаивающий дольше keep_alive, завершается, пока потоков больше min_threads
+        std::chrono::milliseconds keep_alive{std::chrono::seconds(30)};
+
+        MT::ThreadPlacement placement = MT::ThreadPlacement::none;
+        // процессоры, между которыми распределяются потоки; пустая - читается из /sys/devices/system
+        // (CpuTopology::detect), узел без процессоров - std::invalid_argument в конструкторе пула
+        MT::CpuTopology topology;
+    };
+
+
+    // Состояние очереди одного уровня приоритета
+    struct PriorityStats {
+        // задачи, ожидающие в очередях
+        size_t queued = 0;
+
+        // время от постановки в очередь до начала выполнения (при PoolOptions::latency_metrics)
+        uint64_t started = 0;
+        std::chrono::nanoseconds wait_mean{0};
+        std::chrono::nanoseconds wait_p50{0};
+        std::chrono::nanoseconds wait_p99{0};
+        std::chrono::nanoseconds wait_max{0};
+    };
+
+
     // Обёртка для потока
     struct Thread {
         std::thread _thread;
-        std::atomic<bool> is_waiting;
         std::atomic<bool> is_working;
-        
-        Thread() : _thread(), is_working(false) {}
-
-        Thread(const std::thread& other) = delete;
-        Thread operator=(const Thread& other) = delete;
-
-        Thread(Thread&& other) noexcept : _thread(std::move(other._thread)), is_working(other.is_working.load()) {	}
-        
-        Thread& operator=(Thread&& other) noexcept {
-            if (this != &other) {
-                _thread = std::move(other._thread);
-                is_working.store(other.is_working.load());
-            }
-            return *this;
-        }
+
+        // порядковый номер потока в пуле
+        size_t index;
+
+        // сколько задач с TaskPriority::high поток взял подряд (меняет только сам поток)
+        size_t high_streak;
+
+        // процессор, к которому привязан поток (-1 - без привязки), и его узел NUMA
+        int cpu;
+        size_t node;
+
+        // локальный дек задач, порождённых задачами этого потока;
+        // переживает завершение потока, поэтому воры могут обращаться к нему в любой момент
+        std::unique_ptr<MT::WorkStealingDeque<MT::Job*>> local_tasks;
+
+        // в ячейке работает поток; сбрасывается потоком при выходе из ThreadPool::run
+        std::atomic<bool> is_alive;
+
+        // задержки задач, выполненных потоками этой ячейки; создаётся при первом запуске потока в ней
+        std::unique_ptr<MT::LatencyRecorder> latency;
+
+        // счётчики для ThreadPool::stats, пишет только поток ячейки
+        MT::WorkerCounters counters;
+
+        Thread() : _thread(), is_working(false), index(0), high_streak(0), cpu(-1), node(0),
+                   local_tasks(std::make_unique<MT::WorkStealingDeque<MT::Job*>>()), is_alive(false) {}
+
+        Thread(const Thread& other) = delete;
+        Thread& operator=(const Thread& other) = delete;
     };
 
 
+    // Контроллер эластичного пула (PoolOptions::max_threads != 0), добавляет потоки под нагрузкой.
+    // Поток контроллера спит, пока пул справляется сам: его будит добавление задачи, не нашедшее
+    // спящего потока, после чего нагрузка проверяется каждые grow_after, пока очередь не разберут.
+    // Лишние потоки завершаются сами, прождав работу дольше keep_alive
     class ThreadPoolController {
-        ThreadPool& pool;
+        MT::ThreadPool& pool;
         std::thread controller_thread;
-        std::atomic<bool> stopped{false};
 
-    public:
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        bool stopped;
 
-        ThreadPoolController(MT::ThreadPool& pool_ref);
-
-        ~ThreadPoolController();
+        // пул сообщил о нехватке потоков, а контроллер ещё не проверил нагрузку
+        std::atomic<bool> pressure;
 
         void monitor();
 
-        void check_for_deadlock();
+     public:
+        explicit ThreadPoolController(MT::ThreadPool& pool_ref);
+
+        ThreadPoolController(const ThreadPoolController& other) = delete;
+        ThreadPoolController& operator=(const ThreadPoolController& other) = delete;
+
+        // вызывается пулом, когда для новой задачи не нашлось спящего потока
+        void notify();
+
+        ~ThreadPoolController();
     };
 
+
     class ThreadPool {
+        friend class TaskGroup;
+        friend class TaskGraph;
         friend class ThreadPoolController;
      public:
-        ThreadPool(size_t NUM_THREADS);
+        ThreadPool(size_t NUM_THREADS, const MT::PoolOptions& options_ = MT::PoolOptions());
 
-        // шаблонная функция добавления задачи в очередь
+        // шаблонная функция добавления задачи в очередь,
+        // возвращает 0, если задача отклонена (FullQueuePolicy::fail)
 		template <typename TaskChild>
-		size_t add_task(std::shared_ptr<TaskChild> task) {
-			std::lock_guard<std::mutex> lock(task_queue_mutex);
-			task_queue.push(std::move(task));
-			// задаём уникальный идентификатор новой задаче, минимальный id равен 1
-			task_queue.back()->task_id = ++last_task_id;
-
-            // Логируем добавление задачи в очередь
-            {
-                std::lock_guard<std::mutex> cl(cout_mutex);
-			    std::cout << "Task submitted with ID: " << last_task_id << '\n';
-            }
-			// связываем задачу с текущим пулом
-			task_queue.back()->thread_pool = this;
-			tasks_access.notify_one();
-			return last_task_id;
+		size_t add_task(std::shared_ptr<TaskChild> task, MT::TaskPriority priority = MT::TaskPriority::normal) {
+			return push_task(std::move(task), priority);
 		}
 
 
+        // добавление вызываемого объекта без результата. Объекты до TaskFunction::inline_size байт
+        // хранятся прямо в узле очереди, так что в установившемся режиме память не выделяется
+        template <typename F>
+        size_t post(F&& f, MT::TaskPriority priority = MT::TaskPriority::normal) {
+            return push_job(MT::TaskFunction(std::forward<F>(f)), nullptr, nullptr, priority);
+        }
+
+
+        // добавление произвольного вызываемого объекта, результат - через TaskFuture,
+        // в хранилище результатов такие задачи не попадают.
+        // Единственное выделение памяти - общее состояние TaskFuture
+        template <typename F, typename... Args>
+        auto submit(F&& f, Args&&... args) {
+            using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+            auto state = std::make_shared<MT::FutureState<R>>();
+            size_t task_id = push_job(MT::TaskFunction(
+                [state, f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable {
+                    try {
+                        if constexpr (std::is_void_v<R>) {
+                            std::invoke(std::move(f), std::move(args)...);
+                            state->set_value();
+                        } else {
+                            state->set_value(std::invoke(std::move(f), std::move(args)...));
+                        }
+                    } catch (...) {
+                        state->set_exception(std::current_exception());
+                        // пул должен учесть задачу как завершившуюся с ошибкой
+                        throw;
+                    }
+                }), nullptr);
+            return make_future(std::move(state), task_id);
+        }
+
+
+        // submit для существующих наследников Task: TaskFuture вернёт саму задачу без dynamic_pointer_cast
+        template <typename TaskChild>
+            requires std::derived_from<TaskChild, MT::Task>
+        MT::TaskFuture<std::shared_ptr<TaskChild>> submit(std::shared_ptr<TaskChild> task) {
+            auto state = std::make_shared<MT::FutureState<std::shared_ptr<TaskChild>>>();
+            TaskChild* raw_task = task.get();
+            size_t task_id = push_job(MT::TaskFunction([state, task = std::move(task)]() {
+                try {
+                    task->one_thread_pre_method();
+                    state->set_value(task);
+                } catch (...) {
+                    state->set_exception(std::current_exception());
+                    throw;
+                }
+            }), raw_task);
+            return make_future(std::move(state), task_id);
+        }
+
+
+        // пакетное добавление задач: один атомарный захват диапазона id,
+        // одна блокировка очереди и пробуждение не более чем n спящих потоков.
+        // Принимает и однопроходные диапазоны: память заранее резервируется, только если размер
+        // известен без лишнего прохода. Возвращает полуинтервал [first, last) выданных id
+        template <std::input_iterator Iterator, std::sentinel_for<Iterator> Sentinel>
+            requires std::convertible_to<std::iter_reference_t<Iterator>, std::shared_ptr<Task>>
+        std::pair<size_t, size_t> add_tasks(Iterator first, Sentinel last) {
+            std::vector<std::shared_ptr<Task>> batch;
+            if constexpr (std::forward_iterator<Iterator>) {
+                batch.reserve(static_cast<size_t>(std::ranges::distance(first, last)));
+            }
+            for (; first != last; ++first) {
+                batch.push_back(*first);
+            }
+            return push_tasks(std::move(batch));
+        }
+
+
+        template <std::ranges::input_range Range>
+            requires std::convertible_to<std::ranges::range_reference_t<Range>, std::shared_ptr<Task>>
+        std::pair<size_t, size_t> add_tasks(Range&& tasks) {
+            return add_tasks(std::ranges::begin(tasks), std::ranges::end(tasks));
+        }
+
+
+        // запуск графа задач: корни ставятся в очередь одной пакетной операцией,
+        // остальные узлы - по мере выполнения их предшественников. Дождаться - TaskGraph::wait()
+        void run_graph(MT::TaskGraph& graph);
+
+
         // получение результата по id (необходимо заранее знать тип возвращаемого объекта)
+        // (nullptr, если результат ещё не готов, вытеснен или уже прочитан с consume_on_read)
 		template <typename TaskChild>
 		std::shared_ptr<TaskChild> get_result(size_t task_id) {
-	        std::lock_guard<std::mutex> lock(completed_tasks_mutex);
-			auto it = completed_tasks.find(task_id);
-			if (it != completed_tasks.end()) {
-				return std::dynamic_pointer_cast<TaskChild>(it->second);
-            } else {
-				return nullptr;
-            }
+			return std::dynamic_pointer_cast<TaskChild>(completed_tasks.find(task_id));
 		}
 
 
@@ -147,52 +378,116 @@ namespace MT {
         // очистить выполненные задач
 		void clear_completed();
 
-        void set_logger_flag(bool flag);
+        // размер хранилища результатов и счётчики вытеснения
+        MT::ResultStoreStats result_store_stats();
 
-        size_t count_of_threads();
+        // глубина очереди и время ожидания задач одного уровня приоритета
+        MT::PriorityStats priority_stats(MT::TaskPriority priority);
+
+        // перцентили ожидания в очереди, выполнения и полного времени задач, всего и по типам задач;
+        // гистограммы потоков сводятся в момент вызова
+        MT::LatencySnapshot latency_snapshot();
 
-        size_t count_waiting_threads();
+        // счётчики задач, очередей и потоков пула и каждой ячейки потока;
+        // собирается из счётчиков потоков в момент вызова, пул при этом не останавливается
+        MT::PoolStats stats();
 
-        void set_current_thread_waiting(bool waiting_status);
+        // узел NUMA вызывающего потока (0 без ThreadPlacement::numa_nodes), подходит для Task::prefer_node
+        size_t current_node() const;
+
+        // число узлов NUMA, между которыми распределены потоки
+        size_t count_of_nodes() const;
+
+        void set_logger_flag(bool flag);
+
+        // получатель событий о задачах (добавлена, начата, выполнена, ошибка),
+        // по умолчанию события не создаются; nullptr снова отключает их
+        void set_event_sink(std::shared_ptr<MT::EventSink> sink);
+
+        size_t count_of_threads();
 
         ~ThreadPool();
 
      private:
         // мьютексы, блокирующие очереди для потокобезопасного обращения
         std::mutex task_queue_mutex;
-        std::mutex completed_tasks_mutex;
-        std::mutex incomplete_tasks_with_an_error_mutex;
 
-        // мьютекс для вывода в консоль
-        std::mutex cout_mutex;
+        // мьютекс, под которым засыпают свободные потоки
+        std::mutex sleep_mutex;
+
+        // мьютекс, под которым ждут места в кольцевом буфере (FullQueuePolicy::block)
+        std::mutex space_mutex;
 
         // мьютекс, блокирующий функции ожидающие результатов (методы wait*)
         std::mutex wait_mutex;
 
-        // мьютекс, блокирующий логер для последовательного вывода
-		std::mutex logger_mutex;
-
         std::condition_variable tasks_access; 
         std::condition_variable wait_access;   
+        std::condition_variable space_access;
+
+        // Ячейки потоков, выделяются один раз на max_threads потоков и не перемещаются,
+        // поэтому их можно просматривать, пока пул растёт или сокращается
+        std::unique_ptr<MT::Thread[]> threads;
+
+        // границы числа потоков (для пула фиксированного размера совпадают)
+        size_t min_threads;
+        size_t max_threads;
+
+        // Число когда-либо занятых ячеек: воры и join просматривают только первые actual_threads_count
+        std::atomic<size_t> actual_threads_count;
 
-        // Набор доступных потоков
-        std::vector<MT::Thread> threads;
+        // число работающих потоков
+        std::atomic<size_t> live_threads;
 
-        const size_t max_threads = 100;
+        // есть только у эластичного пула
+        std::unique_ptr<MT::ThreadPoolController> controller;
 
-        // Хранит число созданных потоков для их корректного завершения
-        size_t actual_threads_count;
+        // запуски и завершения потоков (редкие события, счётчики общие)
+        std::atomic<uint64_t> threads_started;
+        std::atomic<uint64_t> threads_retired;
 
-        // Очередь задач
-        std::queue<std::shared_ptr<Task>> task_queue;
-        size_t last_task_id;
+        // ожидания мьютексов очередей потоками вне пула; у потоков пула - свои счётчики
+        alignas(64) std::atomic<uint64_t> external_lock_contentions;
+
+        const MT::PoolOptions options;
+
+        // Очередь задач (при work stealing - только задачи, пришедшие извне пула)
+        MT::JobList task_queue;
+
+        // Общая очередь под мьютексом: для задач с приоритетом, отличным от TaskPriority::normal,
+        // и для очередей узлов NUMA
+        struct SharedJobQueue {
+            std::mutex mutex;
+            MT::JobList jobs;
+            // позволяет не захватывать мьютекс пустой очереди
+            std::atomic<size_t> size{0};
+        };
 
-        // массив выполненных задач в виде хэш-таблицы
-		std::unordered_map<size_t, std::shared_ptr<Task>> completed_tasks;
-		size_t completed_task_count;
+        SharedJobQueue high_tasks;
+        SharedJobQueue low_tasks;
 
-        // id задач, в которых возникла ошибка при выполнении
-        std::unordered_set<size_t> incomplete_tasks_with_an_error;
+        // очереди узлов NUMA для задач извне пула (только при ThreadPlacement::numa_nodes)
+        std::vector<std::unique_ptr<SharedJobQueue>> node_queues;
+
+        // номер узла по номеру процессора
+        std::vector<size_t> cpu_nodes;
+
+        // Замена task_queue для QueueType::bounded_ring
+        std::unique_ptr<MT::BoundedMPMCQueue<MT::Job*>> ring_queue;
+        // число производителей, ждущих места в ring_queue
+        std::atomic<size_t> blocked_producers;
+        std::atomic<size_t> last_task_id;
+
+        // число задач, лежащих во всех очередях пула; увеличивается до того, как задача
+        // станет видна потокам, а уменьшается после её извлечения, поэтому не уходит ниже нуля
+        std::atomic<size_t> queued_tasks;
+        // число потоков, спящих на tasks_access
+        std::atomic<size_t> sleeping_threads;
+
+        // выполненные задачи и отметки о задачах с ошибкой, ограниченные PoolOptions::result_retention
+		MT::ResultStore completed_tasks;
+		std::atomic<size_t> completed_task_count;
+        std::atomic<size_t> failed_task_count;
 
         // флаг остановки работы пула
         std::atomic<bool> stopped;
@@ -203,16 +498,116 @@ namespace MT {
 
         Logger logger;
 
-        MT::ThreadPoolController controller;
+        // доставка событий о задачах в фоновом потоке, вне блокировок пула
+        MT::EventDispatcher events;
 
         // основная функция, инициализирующая каждый поток
 		void run(MT::Thread& thread);
 
+        // запускает поток в свободной ячейке, false - свободной ячейки нет;
+        // вызывается только конструктором и потоком контроллера
+        bool add_worker();
+
+        // разрешает простаивающему потоку завершиться, если потоков больше min_threads
+        bool retire_worker();
+
+        // в очереди есть задачи, но нет спящих потоков, которые могли бы их взять
+        bool is_overloaded() const;
+
+        // сколько задач уже покинуло очереди (с начала работы пула)
+        size_t dequeued_count() const;
+
+        // queued_tasks, ограниченный числом невыполненных задач: значение для статистики и метрик
+        // не может оказаться больше числа задач, которые вообще могут стоять в очереди
+        size_t queued_count() const;
+
+        // работа для задачи-наследника Task: выполнить и сохранить результат в completed_tasks
+        MT::TaskFunction wrap_task(std::shared_ptr<Task> task);
+
+        size_t push_task(std::shared_ptr<Task> task, MT::TaskPriority priority = MT::TaskPriority::normal);
+
+        // выдаёт работе id и кладёт её в локальный дек текущего потока пула или в общую очередь;
+        // task - задача-наследник Task, от имени которой выполняется работа (или nullptr),
+        // listener - кому сообщить о выполнении (или nullptr)
+        size_t push_job(MT::TaskFunction&& fn, MT::Task* task, MT::JobListener* listener = nullptr,
+                        MT::TaskPriority priority = MT::TaskPriority::normal);
+
+        // пакетная постановка готовых узлов: один захват диапазона id и одна блокировка очереди,
+        // возвращает полуинтервал [first, last) выданных id
+        std::pair<size_t, size_t> push_jobs(std::vector<MT::Job*>&& jobs);
+
+        // пакетный вариант push_task
+        std::pair<size_t, size_t> push_tasks(std::vector<std::shared_ptr<Task>>&& tasks, MT::JobListener* listener = nullptr);
+
+        template <typename R>
+        MT::TaskFuture<R> make_future(std::shared_ptr<MT::FutureState<R>> state, size_t task_id) {
+            if (task_id == 0) {
+                state->set_exception(std::make_exception_ptr(std::runtime_error("Task queue is full")));
+            }
+            return MT::TaskFuture<R>(std::move(state), task_id);
+        }
+
+        // кладёт работу в ring_queue с учётом FullQueuePolicy, false - работа отклонена
+        bool push_to_ring(MT::Job* job);
+
+        // достаёт работу: high -> состарившиеся low -> свой дек (LIFO) -> общая очередь -> кража (FIFO) -> low
+        MT::Job* take_job(MT::Thread& thread);
+
+        // работа с приоритетом TaskPriority::normal: свой дек, общая очередь, кража у других потоков
+        MT::Job* take_normal_job(MT::Thread& thread);
+
+        // работа из общей очереди; only_aged - только если она ждёт дольше low_priority_aging
+        MT::Job* take_shared_job(SharedJobQueue& queue, bool only_aged);
+
+        // кража из деков других потоков своего (same_node) или остальных узлов NUMA
+        MT::Job* steal_job(MT::Thread& thread, bool same_node);
+
+        void push_to_shared(SharedJobQueue& queue, MT::Job* job);
+
+        // захват мьютекса очереди с учётом ожидания в WorkerCounters::lock_contentions
+        std::unique_lock<std::mutex> lock_queue(std::mutex& mutex);
+
+        // работа предпочитает узел NUMA, отличный от узла вызывающего потока
+        bool is_remote_job(const MT::Job* job) const;
+
+        // очередь узла для работы: предпочитаемого ею или узла вызывающего потока
+        SharedJobQueue& node_queue_for(const MT::Job* job);
+
+        // выполняет работу, учитывает результат и возвращает узел в JobPool
+        void execute_job(MT::Job* job);
+
+        // выполняет одну работу из очередей, если вызван из потока этого пула (для TaskGroup::wait),
+        // false - если выполнять нечего
+        bool run_pending_task();
+
+        // поток пула, ждущий группу или граф, засыпает вместе с простаивающими потоками и просыпается,
+        // когда в очередях появляется работа или done() становится true (об этом сообщает wake_helpers)
+        template <typename Done>
+        void sleep_until_work(Done done) {
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleeping_threads.fetch_add(1);
+            tasks_access.wait(lock, [this, &done]() -> bool { return done() || run_allowed() || stopped.load(); });
+            sleeping_threads.fetch_sub(1);
+        }
+
+        // будит потоки, ждущие в sleep_until_work, после того как их условие стало истинным
+        void wake_helpers();
+
+        // true, если вызван из потока этого пула
+        bool is_pool_thread() const;
+
+        // будит не более count спящих потоков
+        void notify_workers(size_t count);
+
+        // отклоняет работу, не поместившуюся в ring_queue (FullQueuePolicy::fail)
+        void reject_job(MT::Job* job);
+
+        // будит wait(), если все задачи выполнены
+        void notify_if_completed();
+
         // разрешение запуска очередного потока
 		bool run_allowed() const;
 
         bool is_comleted() const;
-
-        void expand();
     };
 }
\ No newline at end of file
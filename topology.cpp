@@ -0,0 +1,142 @@
+#include "topology.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <ranges>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+namespace {
+	// первая строка файла из /sys, пустая строка - если файла нет
+	std::string read_line(const std::string& path) {
+		std::ifstream file(path);
+		std::string line;
+		std::getline(file, line);
+		return line;
+	}
+
+
+	// процессоры, на которых разрешено выполняться вызывающему потоку (taskset, cpuset cgroups),
+	// по возрастанию; пусто - маска недоступна
+	std::vector<size_t> allowed_cpus() {
+		std::vector<size_t> cpus;
+#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+			for (size_t cpu : std::ranges::iota_view(static_cast<size_t>(0), static_cast<size_t>(CPU_SETSIZE))) {
+				if (CPU_ISSET(cpu, &set)) {
+					cpus.push_back(cpu);
+				}
+			}
+		}
+#endif
+		return cpus;
+	}
+
+
+	// оставляет в cpus только разрешённые процессоры; пустой allowed ничего не ограничивает
+	void keep_allowed(std::vector<size_t>& cpus, const std::vector<size_t>& allowed) {
+		if (!allowed.empty()) {
+			std::erase_if(cpus, [&allowed](size_t cpu) { return !std::ranges::binary_search(allowed, cpu); });
+		}
+	}
+}
+
+
+std::vector<size_t> MT::parse_cpu_list(std::string_view list) {
+	std::vector<size_t> cpus;
+	while (!list.empty()) {
+		size_t comma = list.find(',');
+		std::string_view range = list.substr(0, comma);
+		list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+		size_t first = 0;
+		auto [end, error] = std::from_chars(range.data(), range.data() + range.size(), first);
+		if (error != std::errc()) {
+			continue;
+		}
+		size_t last = first;
+		if (end != range.data() + range.size() && *end == '-') {
+			std::from_chars(end + 1, range.data() + range.size(), last);
+		}
+		for (size_t cpu : std::ranges::iota_view(first, std::max(first, last) + 1)) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+
+MT::CpuTopology MT::CpuTopology::detect() {
+	MT::CpuTopology topology;
+	std::vector<size_t> allowed = allowed_cpus();
+
+	for (size_t node : parse_cpu_list(read_line("/sys/devices/system/node/online"))) {
+		std::vector<size_t> cpus = parse_cpu_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+		keep_allowed(cpus, allowed);
+		if (!cpus.empty()) {
+			topology.nodes.push_back(std::move(cpus));
+		}
+	}
+
+	if (topology.empty()) {
+		std::vector<size_t> cpus = parse_cpu_list(read_line("/sys/devices/system/cpu/online"));
+		keep_allowed(cpus, allowed);
+		if (cpus.empty()) {
+			cpus = allowed;
+		}
+		if (cpus.empty()) {
+			size_t count = std::max(1u, std::thread::hardware_concurrency());
+			for (size_t cpu : std::ranges::iota_view(static_cast<size_t>(0), count)) {
+				cpus.push_back(cpu);
+			}
+		}
+		topology.nodes.push_back(std::move(cpus));
+	}
+	return topology;
+}
+
+
+bool MT::CpuTopology::empty() const {
+	return nodes.empty();
+}
+
+
+size_t MT::CpuTopology::cpus_count() const {
+	size_t count = 0;
+	for (const std::vector<size_t>& cpus : nodes) {
+		count += cpus.size();
+	}
+	return count;
+}
+
+
+bool MT::pin_current_thread(size_t cpu) {
+#ifdef __linux__
+	if (cpu >= CPU_SETSIZE) {
+		return false;
+	}
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+
+int MT::current_cpu() {
+#ifdef __linux__
+	return sched_getcpu();
+#else
+	return -1;
+#endif
+}
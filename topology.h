@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+
+namespace MT {
+
+    // Процессоры машины, сгруппированные по узлам NUMA
+    struct CpuTopology {
+        // nodes[i] - номера процессоров i-го узла; узлы без процессоров не хранятся,
+        // поэтому номер узла здесь может не совпадать с номером узла в системе
+        std::vector<std::vector<size_t>> nodes;
+
+        // читает топологию из /sys/devices/system/node (или /sys/devices/system/cpu/online,
+        // если узлы недоступны), оставляя только процессоры из маски sched_getaffinity вызывающего
+        // потока (taskset, cgroups); при неудаче - один узел из std::thread::hardware_concurrency() процессоров
+        static CpuTopology detect();
+
+        bool empty() const;
+
+        size_t cpus_count() const;
+    };
+
+
+    // разбирает список процессоров в формате /sys, например "0-3,8,10-11"
+    std::vector<size_t> parse_cpu_list(std::string_view list);
+
+    // привязывает вызывающий поток к процессору, false - привязка не поддерживается или не удалась
+    bool pin_current_thread(size_t cpu);
+
+    // процессор, на котором сейчас выполняется вызывающий поток, -1 - если неизвестно
+    int current_cpu();
+}
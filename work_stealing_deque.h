@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+
+namespace MT {
+
+    // Дек Chase-Lev для кражи работы (work stealing).
+    // Владелец (поток пула) кладёт и забирает элементы с "нижнего" конца (LIFO),
+    // остальные потоки воруют с "верхнего" конца (FIFO).
+    // Хранит только тривиально копируемые значения (в пуле - указатели на задачи).
+    template <typename T>
+    class WorkStealingDeque {
+        static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque stores trivially copyable values only");
+
+        // Кольцевой буфер, размер которого всегда является степенью двойки
+        struct Array {
+            int64_t capacity;
+            int64_t mask;
+            std::unique_ptr<std::atomic<T>[]> buffer;
+
+            explicit Array(int64_t capacity_) :
+                capacity(capacity_), mask(capacity_ - 1), buffer(new std::atomic<T>[capacity_]) {}
+
+            T load(int64_t i) const {
+                return buffer[i & mask].load(std::memory_order_relaxed);
+            }
+
+            void store(int64_t i, T value) {
+                buffer[i & mask].store(value, std::memory_order_relaxed);
+            }
+
+            Array* grow(int64_t bottom, int64_t top) const {
+                Array* new_array = new Array(capacity * 2);
+                for (int64_t i = top; i != bottom; ++i) {
+                    new_array->store(i, load(i));
+                }
+                return new_array;
+            }
+        };
+
+        alignas(64) std::atomic<int64_t> top;
+        alignas(64) std::atomic<int64_t> bottom;
+        alignas(64) std::atomic<Array*> array;
+
+        // Старые буферы нельзя освободить сразу - их ещё может читать вор,
+        // поэтому они живут до уничтожения дека (используется только владельцем)
+        std::vector<std::unique_ptr<Array>> retired;
+
+     public:
+        explicit WorkStealingDeque(int64_t capacity = 256) : top(0), bottom(0), array(new Array(capacity)) {}
+
+        WorkStealingDeque(const WorkStealingDeque& other) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+        ~WorkStealingDeque() {
+            delete array.load();
+        }
+
+        // Вызывается только владельцем
+        void push(T value) {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            Array* a = array.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1) {
+                Array* bigger = a->grow(b, t);
+                retired.emplace_back(a);
+                array.store(bigger, std::memory_order_release);
+                a = bigger;
+            }
+            a->store(b, value);
+            // release-запись вместо барьера с relaxed-записью: то же упорядочивание,
+            // но понятное ThreadSanitizer, который не учитывает отдельные барьеры
+            bottom.store(b + 1, std::memory_order_release);
+        }
+
+        // Вызывается только владельцем, забирает последний добавленный элемент
+        std::optional<T> pop() {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            Array* a = array.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                // дек пуст
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+
+            T value = a->load(b);
+            if (t == b) {
+                // последний элемент - соревнуемся с ворами
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    bottom.store(b + 1, std::memory_order_relaxed);
+                    return std::nullopt;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return value;
+        }
+
+        // Может вызываться любым потоком, забирает самый старый элемент
+        std::optional<T> steal() {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+
+            if (t >= b) {
+                return std::nullopt;
+            }
+
+            Array* a = array.load(std::memory_order_consume);
+            T value = a->load(t);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        size_t size() const {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<size_t>(b - t) : 0;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+    };
+}